@@ -1,6 +1,7 @@
 #ifndef TABLE_H_
 #define TABLE_H_
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -23,6 +24,25 @@ typedef enum table_order
  ,TABLE_DESCENDING
 } table_order;
 
+/**
+ * \brief Table storage layouts
+ */
+typedef enum table_storage
+{
+  TABLE_ROW_STORAGE
+ ,TABLE_COLUMN_STORAGE
+} table_storage;
+
+/**
+ * \brief Table buffer ownership
+ */
+typedef enum table_ownership
+{
+  TABLE_COPY   /**< The values are copied and the caller keeps the buffer */
+ ,TABLE_ADOPT  /**< The table takes the buffer, which must come from malloc() */
+ ,TABLE_BORROW /**< The table reads the buffer in place until the column is modified */
+} table_ownership;
+
 /**
  * \brief Table data types
  */
@@ -81,14 +101,93 @@ typedef struct table_column
   char *name;    /**< The name of the column */
   table_data_type type; /**< The column data type */
   table_comparator comparator; /**< The column comparator function */
+  table_storage storage; /**< The column storage layout */
+  int cell_index; /**< The row cell index of a row storage column */
+  void *data; /**< The contiguous values of a column storage column */
+  uint64_t *validity; /**< The packed validity bitmap, one bit per row */
+  int null_count; /**< The number of rows without a value */
+  size_t borrowed; /**< The number of values borrowed from the caller, 0 when the column owns its data */
+  uint64_t *prefixes; /**< The cached normalised prefix of the string of each row, for binary searches */
+  int prefixes_length; /**< The number of rows the cached prefixes cover */
+  unsigned long prefixes_generation; /**< The generation of the table the prefixes were cached at */
+  struct table_hash_index *hash_index; /**< The hash index of the column, or NULL */
 } table_column;
 
+/**
+ * \brief A view of the values of a column as a strided array
+ *
+ * Row n has a value when bit n % 64 of word n / 64 of the validity bitmap is
+ * set, its value is then at base + n * stride. String and pointer columns
+ * hold pointers to their values. The view is invalidated when the generation
+ * of the table changes.
+ */
+typedef struct table_column_view
+{
+  const void *base; /**< The address of the value of the first row */
+  size_t stride; /**< The distance in bytes between the values of consecutive rows */
+  int length; /**< The number of rows */
+  table_data_type type; /**< The column data type */
+  const uint64_t *validity; /**< The packed validity bitmap, one bit per row */
+  int null_count; /**< The number of rows without a value */
+  unsigned long generation; /**< The generation of the table the view was taken at */
+} table_column_view;
+
+/**
+ * \brief A multi-column sort specification
+ *
+ * A specification can be built once and used for any number of sorts. The
+ * buffers used while sorting are kept between sorts.
+ */
+typedef struct table_sort_spec
+{
+  int *cols; /**< The columns to sort by, most significant first */
+  table_order *orders; /**< The order to sort each column in */
+  int length; /**< The number of columns */
+  int *rows; /**< The row permutation buffer */
+  int *scratch; /**< The merge scratch buffer */
+  size_t allocated; /**< The number of rows the buffers hold */
+} table_sort_spec;
+
+/**
+ * \brief A union to hold a table cell value in place
+ *
+ * Fixed width values are stored inline, strings and pointers are stored by
+ * address. The active member is determined by the column data type.
+ */
+typedef union table_value
+{
+  bool b;
+  int i;
+  unsigned int ui;
+  int8_t i8;
+  uint8_t ui8;
+  int16_t i16;
+  uint16_t ui16;
+  int32_t i32;
+  uint32_t ui32;
+  int64_t i64;
+  uint64_t ui64;
+  short sh;
+  unsigned short ush;
+  long l;
+  unsigned long ul;
+  long long ll;
+  unsigned long long ull;
+  float f;
+  double d;
+  long double ld;
+  char c;
+  unsigned char uc;
+  char *str;
+  void *ptr;
+} table_value;
+
 /**
  * \brief A structure to represent table cells
  */
 typedef struct table_cell
 {
-  void *value; /**< The value of the table cell */
+  table_value value; /**< The value of the table cell */
 } table_cell;
 
 /**
@@ -97,10 +196,15 @@ typedef struct table_cell
 typedef struct table_row
 {
   table_cell *cells; /**< A pointer to an array of table cells */
+  size_t cells_allocated; /**< The number of cells allocated in the row */
+  bool removed; /**< Whether the row is a tombstone awaiting compaction */
 } table_row;
 
-/* Forward declaration */
+/* Forward declarations */
 typedef struct table table;
+typedef struct table_slab table_slab;
+typedef struct table_hash_index table_hash_index;
+typedef struct table_index table_index;
 
 /**
  * \brief A table callback, handles table event notifications
@@ -112,6 +216,76 @@ typedef void (*table_callback)(table *t, int row, int column, table_event_type e
  */
 typedef unsigned int table_bitfield;
 
+/**
+ * \brief A table row predicate, selects rows for bulk operations
+ */
+typedef bool (*table_row_predicate)(const table *t, int row, void *data);
+
+/**
+ * \brief A table row visitor, receives rows in turn and returns false to stop
+ */
+typedef bool (*table_row_visitor)(const table *t, int row, void *data);
+
+/**
+ * \brief A table growth policy
+ *
+ * Allocations grow by the larger of the growth factor and the block size
+ * when full. They shrink once fewer than the shrink threshold fraction of
+ * them are in use, leaving room for the growth factor, so that workloads
+ * oscillating around a boundary do not reallocate on every change.
+ */
+typedef struct table_growth_policy
+{
+  double growth_factor; /**< The factor a full allocation grows by, at least 1 */
+  double shrink_threshold; /**< The fraction in use below which an allocation shrinks, 0 never shrinks */
+} table_growth_policy;
+
+/**
+ * \brief A sorted view of a table
+ *
+ * The view orders the rows of a table without moving them. Index n of the
+ * view is table row rows[n]. The view is stale once rows are added, removed
+ * or moved, and does not follow changes to the values it was sorted by until
+ * it is refreshed.
+ */
+typedef struct table_sorted_view
+{
+  const table *t; /**< The table viewed */
+  table_sort_spec spec; /**< The sort specification of the view */
+  int *rows; /**< The table row at each index of the view */
+  int length; /**< The number of rows in the view */
+  int allocated; /**< The number of rows allocated */
+  unsigned long generation; /**< The generation of the table the view was sorted at */
+} table_sorted_view;
+
+/**
+ * \brief A selection of the rows of a table
+ *
+ * A selection holds rows in ascending order, as found by table_find_all().
+ * It can be handed on to other table operations, such as table_remove_rows(),
+ * and is stale once rows are added, removed or moved.
+ */
+typedef struct table_selection
+{
+  const table *t; /**< The table the rows were selected from */
+  int *rows; /**< The selected rows in ascending order */
+  int length; /**< The number of rows selected */
+  int allocated; /**< The number of rows allocated */
+  unsigned long generation; /**< The generation of the table the rows were selected at */
+} table_selection;
+
+/**
+ * \brief The options of an external sort
+ *
+ * An external sort sorts runs of rows that fit in the memory budget, spills
+ * each sorted run to a temporary file and merges the runs back.
+ */
+typedef struct table_external_sort_options
+{
+  const char *temp_dir; /**< The directory of the temporary files, NULL for the system default */
+  size_t memory_budget; /**< The bytes the runs and merge buffers may use, 0 for the default */
+} table_external_sort_options;
+
 /**
  * \brief A structure to represent a table
  */
@@ -122,12 +296,24 @@ struct table
   int column_length; /**< The length of the array of table columns */
   size_t column_block; /**< The column block size */
   size_t columns_allocated; /**< The number of columns allocated */
+  size_t columns_reserved; /**< The number of columns kept allocated */
+  table_storage storage; /**< The storage layout of new columns */
+  unsigned long generation; /**< Incremented whenever column views are invalidated */
+
+  /* Cells */
+  int cells_length; /**< The number of cell slots assigned to columns */
+  size_t cells_allocated; /**< The number of cells rows are allocated or widened to */
+  int *cells_free; /**< The cell slots released by removed columns */
+  int cells_free_length; /**< The number of released cell slots */
 
   /* Rows */
   table_row *rows; /**< A pointer to an array of table rows */
   int rows_length; /**< The length of the array of table rows */
   size_t row_block; /**< The row block size */
   size_t rows_allocated; /**< The number of rows allocated */
+  size_t rows_reserved; /**< The number of rows kept allocated */
+  int rows_removed; /**< The number of tombstoned rows */
+  double tombstone_threshold; /**< The fraction of tombstoned rows that triggers compaction, 0 removes rows immediately */
 
   /* Callbacks */
   int callbacks_length; /**< The length of the array of table callbacks */
@@ -136,6 +322,19 @@ struct table
   table_bitfield *callbacks_registration; /**< The registration bits */
   size_t callbacks_block; /**< The callback block size */
   size_t callbacks_allocated; /**< The number of callbacks allocated */
+
+  /* Arena */
+  size_t slab_size; /**< The arena slab size, 0 when the arena is disabled */
+  table_slab *slabs; /**< The arena slabs */
+
+  /* Growth */
+  table_growth_policy growth; /**< The growth policy of rows, columns and callbacks */
+
+  /* Sortedness */
+  table_sort_spec sort; /**< The columns the rows were last sorted by */
+  bool sorted; /**< Whether the rows are still in the order of sort */
+  int sort_unchecked; /**< The row added last, checked once its values are likely set, or -1 */
+  bool sort_on_find; /**< Whether table_sorted_lookup() re-sorts rows that are out of order first */
 };
 
 static const int TABLE_INDEX_NOT_FOUND = -1;
@@ -146,15 +345,34 @@ void table_delete(void *t);
 void table_init(table *t);
 void table_destroy(table *t);
 table *table_dupe(table *t);
+void table_clear(table *t);
+int table_set_arena(table *t, size_t slab_size);
+size_t table_get_arena(const table *t);
+int table_reserve_rows(table *t, int rows);
+int table_reserve_columns(table *t, int columns);
+void table_shrink_to_fit(table *t);
+int table_set_growth_policy(table *t, table_growth_policy policy);
+table_growth_policy table_get_growth_policy(const table *t);
 
 /* Row and column manipulation */
 int table_add_column(table *t, const char *name, table_data_type data_type);
+int table_add_columns(table *t, const char **names, const table_data_type *data_types, int length);
+int table_add_column_from_buffer(table *t, const char *name, table_data_type data_type, void *data, size_t length, table_ownership ownership);
 int table_remove_column(table *t, int col);
 int table_add_row(table *t);
+int table_append_rows(table *t, int length);
 int table_remove_row(table *t, int row);
+int table_remove_rows(table *t, const int *rows, int length);
+int table_remove_rows_where(table *t, table_row_predicate predicate, void *data);
+int table_set_tombstone_threshold(table *t, double threshold);
+double table_get_tombstone_threshold(const table *t);
+bool table_row_is_removed(const table *t, int row);
+int table_compact_rows(table *t);
 
 /* Cell value manipulation */
 int table_set(table *t, int row, int col, void* value, table_data_type data_type);
+int table_set_block(table *t, int first_row, int first_col, int nrows, int ncols, const void *buf, const table_data_type *types);
+int table_set_block_column_major(table *t, int first_row, int first_col, int nrows, int ncols, const void *buf, const table_data_type *types);
 int table_set_bool(table *t, int row, int col, bool value);
 int table_set_int(table *t, int row, int col, int value);
 int table_set_uint(table *t, int row, int col, unsigned int value);
@@ -235,6 +453,31 @@ int table_find_ptr(const table *t, int column_index, void *value, table_order or
 
 int table_subset_find(const table *t, int column_index, void* value, table_order order, int minimum_index, int maximum_index);
 
+int table_find_all(const table *t, int column_index, void *value, table_selection *out);
+int table_find_all_limit(const table *t, int column_index, void *value, int limit, table_selection *out);
+int table_subset_find_all(const table *t, int column_index, void *value, int minimum_index, int maximum_index, int limit, table_selection *out);
+int table_count(const table *t, int column_index, void *value);
+
+/* Selections */
+void table_selection_init(table_selection *selection);
+void table_selection_destroy(table_selection *selection);
+bool table_selection_is_valid(const table_selection *selection);
+int table_selection_get_length(const table_selection *selection);
+int table_selection_get_row(const table_selection *selection, int index);
+bool table_selection_contains(const table_selection *selection, int row);
+int table_remove_selection(table *t, const table_selection *selection);
+
+/* Hash indexes */
+int table_create_hash_index(table *t, int col);
+void table_drop_hash_index(table *t, int col);
+bool table_has_hash_index(const table *t, int col);
+
+/* Ordered indexes */
+table_index *table_create_index(table *t, int col);
+void table_drop_index(table_index *index);
+int table_index_get_length(const table_index *index);
+int table_index_range(table_index *index, const void *lo, const void *hi, table_row_visitor visitor, void *data);
+
 /* Binary search functions */
 int table_sorted_find(const table *t, int col, void *value, table_position position);
 int table_sorted_find_int(const table *t, int col, int value, table_position position);
@@ -261,8 +504,17 @@ int table_sorted_find_uchar(const table *t, int col, unsigned char value, table_
 int table_sorted_find_string(const table *t, int col, const char *value, table_position position);
 int table_sorted_find_ptr(const table *t, int col, void *value, table_position position);
 
+int table_sorted_lower_bound(const table *t, int col, void *value);
+int table_sorted_upper_bound(const table *t, int col, void *value);
+int table_sorted_equal_range(const table *t, int col, void *value, int *first, int *last);
+int table_sorted_count(const table *t, int col, void *value);
+int table_sorted_lookup(table *t, int col, void *value, table_position position);
+int table_sorted_lookup_equal_range(table *t, int col, void *value, int *first, int *last);
+
 /* Binary search within a row subset */
 int table_sorted_subset_find(const table *t, int col, void *value, table_position position, int minimum, int maximum);
+int table_sorted_subset_equal_range(const table *t, int col, void *value, table_order order, int minimum, int maximum,
+                                    int *first, int *last);
 int table_sorted_subset_find_int(const table *t, int col, int value, table_position position, int minimum, int maximum);
 int table_sorted_subset_find_uint(const table *t, int col, unsigned int value, table_position position, int minimum, int maximum);
 int table_sorted_subset_find_int8(const table *t, int col, int8_t value, table_position position, int minimum, int maximum);
@@ -297,17 +549,53 @@ table_data_type table_get_column_data_type(const table *t, int col);
 int table_get_column(const table *t, const char *name);
 const char *table_get_column_name(const table *t, int col);
 int table_cell_nullify(table *t, int row, int col);
+int table_column_null_count(const table *t, int col);
+const uint64_t *table_get_column_validity(const table *t, int col);
 table_comparator table_get_column_comparator(const table *t, int column);
 void table_set_column_comparator(table *t, int column, table_comparator function);
 
+/* Storage */
+void table_set_storage(table *t, table_storage storage);
+table_storage table_get_storage(const table *t);
+table_storage table_get_column_storage(const table *t, int col);
+int table_set_column_storage(table *t, int col, table_storage storage);
+table_column_view table_get_column_view(table *t, int col);
+bool table_column_view_is_valid(const table *t, const table_column_view *view);
+
 /* Sort */
 void table_column_sort(table *t, int *cols, table_order *sort_orders, int num_cols);
+void table_column_sort_parallel(table *t, int *cols, table_order *sort_orders, int num_cols, int num_threads);
+int table_sort_spec_init(table_sort_spec *spec, const int *cols, const table_order *orders, int length);
+void table_sort_spec_destroy(table_sort_spec *spec);
+void table_sort(table *t, table_sort_spec *spec);
+void table_sort_parallel(table *t, table_sort_spec *spec, int num_threads);
+int table_argsort(const table *t, table_sort_spec *spec, int *perm);
+int table_sort_external(table *t, const table_sort_spec *spec, const table_external_sort_options *options);
+int table_sort_external_to_stream(const table *t, const table_sort_spec *spec, const table_external_sort_options *options, FILE *stream);
+
+/* Sorted views */
+int table_sorted_view_init(table_sorted_view *view, const table *t, const int *cols, const table_order *orders, int length);
+void table_sorted_view_destroy(table_sorted_view *view);
+int table_sorted_view_refresh(table_sorted_view *view);
+bool table_sorted_view_is_valid(const table_sorted_view *view);
+int table_sorted_view_get_length(const table_sorted_view *view);
+int table_sorted_view_get_row(const table_sorted_view *view, int index);
+void *table_sorted_view_get(const table_sorted_view *view, int index, int col);
+int table_sorted_view_find(const table_sorted_view *view, int col, void *value, table_position position);
+int table_top_k(const table *t, const int *cols, const table_order *orders, int num_cols, int k, int *rows);
+int table_partial_sort(table *t, const int *cols, const table_order *orders, int num_cols, int k);
+const table_sort_spec *table_get_sort_spec(const table *t);
+bool table_is_sorted(const table *t);
+int table_resort(table *t);
+void table_set_sort_on_find(table *t, bool sort_on_find);
+bool table_get_sort_on_find(const table *t);
 
 /* Validators */
 int table_column_is_valid(const table *t, int col);
 int table_row_is_valid(const table *t, int row);
 int table_cell_is_valid(const table *t, int row, int col);
 int table_cell_has_value(const table *t, int row, int col);
+int table_column_is_dense(const table *t, int col);
 
 /* Register callbacks */
 void table_register_callback(table *t, table_callback func, void *data, table_bitfield event_types);
@@ -11,6 +11,9 @@
 static void table_init_rows(table *t);
 static void table_init_columns(table *t);
 static void table_init_callbacks(table *t);
+static void table_init_arena(table *t);
+static void table_init_growth(table *t);
+static void table_init_sort(table *t);
 static void table_destroy_rows(table *t);
 static void table_destroy_columns(table *t);
 static void table_destroy_callbacks(table *t);
@@ -18,6 +21,9 @@ static void table_destroy_callbacks(table *t);
 static const size_t DEFAULT_COLUMN_BLOCK = 10;
 static const size_t DEFAULT_ROW_BLOCK = 20;
 static const size_t DEFAULT_CALLBACK_BLOCK = 10;
+static const double DEFAULT_GROWTH_FACTOR = 2.0;
+static const double DEFAULT_SHRINK_THRESHOLD = 0.25;
+
 
 /**
  * \brief Return a fully constructed table pointer
@@ -48,6 +54,9 @@ void table_init(table *t)
   table_init_columns(t);
   table_init_rows(t);
   table_init_callbacks(t);
+  table_init_arena(t);
+  table_init_growth(t);
+  table_init_sort(t);
 }
 
 /**
@@ -59,7 +68,14 @@ static void table_init_columns(table *t)
   t->columns = NULL;
   t->column_length = 0;
   t->columns_allocated = 0;
+  t->columns_reserved = 0;
   t->column_block = DEFAULT_COLUMN_BLOCK;
+  t->storage = TABLE_ROW_STORAGE;
+  t->generation = 0;
+  t->cells_length = 0;
+  t->cells_allocated = 0;
+  t->cells_free = NULL;
+  t->cells_free_length = 0;
 }
 
 /**
@@ -71,6 +87,9 @@ static void table_init_rows(table *t)
   t->rows = NULL;
   t->rows_length = 0;
   t->rows_allocated = 0;
+  t->rows_reserved = 0;
+  t->rows_removed = 0;
+  t->tombstone_threshold = 0.0;
   t->row_block = DEFAULT_ROW_BLOCK;
 }
 
@@ -88,6 +107,37 @@ static void table_init_callbacks(table *t)
   t->callbacks_block = DEFAULT_CALLBACK_BLOCK;
 }
 
+/**
+ * \brief Initialize a tables arena members
+ * \param[in] t The table
+ */
+static void table_init_arena(table *t)
+{
+  t->slab_size = 0;
+  t->slabs = NULL;
+}
+
+/**
+ * \brief Initialize a tables growth policy
+ * \param[in] t The table
+ */
+static void table_init_growth(table *t)
+{
+  t->growth.growth_factor = DEFAULT_GROWTH_FACTOR;
+  t->growth.shrink_threshold = DEFAULT_SHRINK_THRESHOLD;
+}
+
+/**
+ * \brief Initialize a tables sortedness members
+ * \param[in] t The table
+ */
+static void table_init_sort(table *t)
+{
+  table_sort_spec_init(&t->sort, NULL, NULL, 0);
+  t->sorted = false;
+  t->sort_unchecked = -1;
+  t->sort_on_find = false;
+}
 
 /**
  * \brief Free the tables allocated memory
@@ -103,6 +153,126 @@ void table_destroy(table *t)
   table_destroy_rows(t);
   table_destroy_columns(t);
   table_destroy_callbacks(t);
+  table_sort_spec_destroy(&t->sort);
+}
+
+/**
+ * \brief Remove every row from the table
+ * \param[out] t The table
+ *
+ * Registered callbacks receive a single TABLE_ROW_REMOVED notification with
+ * a row of -1. When the arena is enabled the rows are released in time
+ * proportional to the number of slabs rather than the number of rows.
+ */
+void table_clear(table *t)
+{
+  size_t previous_allocated = t->rows_allocated;
+  int column_length = table_get_column_length(t);
+
+  table_destroy_rows(t);
+  t->rows = NULL;
+  t->rows_length = 0;
+  t->rows_allocated = 0;
+  t->rows_removed = 0;
+  table_storage_resize_rows(t, previous_allocated);
+
+  for (int column_index = 0; column_index < column_length; column_index++)
+    table_get_col_ptr(t, column_index)->null_count = 0;
+
+  table_notify(t, -1, -1, TABLE_ROW_REMOVED);
+}
+
+/**
+ * \brief Release the unused capacity of the table
+ * \param[out] t The table
+ *
+ * Rows, columns and callbacks are reallocated to their current lengths and
+ * any reservations are dropped. The cells of every row are compacted,
+ * dropping the slots of removed columns.
+ */
+void table_shrink_to_fit(table *t)
+{
+  t->rows_reserved = 0;
+  t->columns_reserved = 0;
+
+  table_resize_rows(t, table_get_row_length(t));
+  table_resize_columns(t, table_get_column_length(t));
+  table_compact_cells(t);
+  table_resize_callbacks(t, table_get_callback_length(t));
+}
+
+/**
+ * \brief Set the growth policy of rows, columns and callbacks
+ * \param[out] t The table
+ * \param[in] policy The growth policy
+ * \return 0 on success, or -1 if the policy would not shrink with hysteresis
+ */
+int table_set_growth_policy(table *t, table_growth_policy policy)
+{
+  if (policy.growth_factor < 1.0 || policy.shrink_threshold < 0.0 ||
+      policy.growth_factor * policy.shrink_threshold >= 1.0)
+    return -1;
+
+  t->growth = policy;
+  return 0;
+}
+
+/**
+ * \brief Get the growth policy of rows, columns and callbacks
+ * \param[in] t The table
+ * \return The growth policy
+ */
+table_growth_policy table_get_growth_policy(const table *t)
+{
+  return t->growth;
+}
+
+/**
+ * \brief Determine the capacity of a full allocation
+ * \param[in] t The table
+ * \param[in] allocated The current capacity
+ * \param[in] block The minimum increment
+ * \param[in] required The minimum capacity
+ * \return The new capacity
+ */
+size_t table_grow_capacity(const table *t, size_t allocated, size_t block, size_t required)
+{
+  size_t capacity = (size_t)(allocated * t->growth.growth_factor);
+
+  if (capacity < allocated + block)
+    capacity = allocated + block;
+
+  if (capacity < required)
+    capacity = required;
+
+  return capacity;
+}
+
+/**
+ * \brief Determine the capacity of an allocation after an element was removed
+ * \param[in] t The table
+ * \param[in] allocated The current capacity
+ * \param[in] block The minimum increment
+ * \param[in] reserved The reserved capacity
+ * \param[in] length The number of elements in use
+ * \return The new capacity, which is the current capacity unless it should shrink
+ */
+size_t table_shrink_capacity(const table *t, size_t allocated, size_t block, size_t reserved, size_t length)
+{
+  size_t capacity;
+
+  if (length >= allocated * t->growth.shrink_threshold)
+    return allocated;
+
+  capacity = (size_t)(length * t->growth.growth_factor);
+
+  if (capacity < length + block)
+    capacity = length + block;
+
+  if (capacity < reserved)
+    capacity = reserved;
+
+  return capacity < allocated ? capacity : allocated;
 }
 
 /**
@@ -114,12 +284,15 @@ static void table_destroy_rows(table *t)
   int row_length, row;
   row_length = table_get_row_length(t);
 
-  /* Free rows and cells */
-  for(row = 0; row < row_length; row++)
-    table_row_destroy(t, row);
+  /* Free rows and cells, arena memory is released with its slabs */
+  if (!t->slab_size)
+    for(row = 0; row < row_length; row++)
+      table_row_destroy(t, row);
 
   if(t->rows)
     free(t->rows);
+
+  table_arena_destroy(t);
 }
 
 /**
@@ -152,6 +325,9 @@ static void table_destroy_columns(table *t)
   
   if (t->columns)
     free(t->columns);
+
+  if (t->cells_free)
+    free(t->cells_free);
 }
 
 /**
@@ -161,13 +337,16 @@ static void table_destroy_columns(table *t)
 table *table_dupe(table *t)
 {
   int num_rows, num_cols;
-  int i, j;
+  int i, j, row;
   table *return_table;
 
   num_rows = table_get_row_length(t);
   num_cols = table_get_column_length(t);
 
   return_table = table_new();
+  table_set_arena(return_table, table_get_arena(t));
+  table_set_growth_policy(return_table, table_get_growth_policy(t));
+  table_set_tombstone_threshold(return_table, table_get_tombstone_threshold(t));
 
   /* Copy column data */
   for(i = 0; i < num_cols; i++)
@@ -178,13 +357,18 @@ table *table_dupe(table *t)
     name = table_get_column_name(t, i);
     type = table_get_column_data_type(t, i);
 
+    table_set_storage(return_table, table_get_column_storage(t, i));
     table_add_column(return_table, name, type);
   }
+  table_set_storage(return_table, table_get_storage(t));
 
   /* Copy data */
   for(i = 0; i < num_rows; i++)
   {
-    table_add_row(return_table);
+    if (table_row_is_removed(t, i))
+      continue;
+
+    row = table_add_row(return_table);
     for(j = 0; j < num_cols; j++)
     {
       switch(table_get_column_data_type(t, j))
@@ -193,168 +377,168 @@ table *table_dupe(table *t)
         {
           int val;
           val = table_get_int(t, i, j);
-          table_set_int(return_table, i, j, val);
+          table_set_int(return_table, row, j, val);
         }
         break;
       case TABLE_UINT:
         {
           unsigned int val;
           val = table_get_uint(t, i, j);
-          table_set_uint(return_table, i, j, val);
+          table_set_uint(return_table, row, j, val);
         }
         break;
       case TABLE_INT8:
         {
           int8_t val;
           val = table_get_int8(t, i, j);
-          table_set_int8(return_table, i, j, val);
+          table_set_int8(return_table, row, j, val);
         }
         break;
       case TABLE_UINT8:
         {
           uint8_t val;
           val = table_get_uint8(t, i, j);
-          table_set_uint8(return_table, i, j, val);
+          table_set_uint8(return_table, row, j, val);
         }
         break;
       case TABLE_INT16:
         {
           int16_t val;
           val = table_get_int16(t, i, j);
-          table_set_int16(return_table, i, j, val);
+          table_set_int16(return_table, row, j, val);
         }
         break;
       case TABLE_UINT16:
         {
           uint16_t val;
           val = table_get_uint16(t, i, j);
-          table_set_uint16(return_table, i, j, val);
+          table_set_uint16(return_table, row, j, val);
         }
         break;
       case TABLE_INT32:
         {
           int32_t val;
           val = table_get_int32(t, i, j);
-          table_set_int32(return_table, i, j, val);
+          table_set_int32(return_table, row, j, val);
         }
         break;
       case TABLE_UINT32:
         {
           uint32_t val;
           val = table_get_uint32(t, i, j);
-          table_set_uint32(return_table, i, j, val);
+          table_set_uint32(return_table, row, j, val);
         }
         break;
       case TABLE_INT64:
         {
           int64_t val;
           val = table_get_int64(t, i, j);
-          table_set_int64(return_table, i, j, val);
+          table_set_int64(return_table, row, j, val);
         }
         break;
       case TABLE_UINT64:
         {
           uint64_t val;
           val = table_get_uint64(t, i, j);
-          table_set_uint64(return_table, i, j, val);
+          table_set_uint64(return_table, row, j, val);
         }
         break;
       case TABLE_SHORT:
         {
           short val;
           val = table_get_short(t, i, j);
-          table_set_short(return_table, i, j, val);
+          table_set_short(return_table, row, j, val);
         }
         break;
       case TABLE_USHORT:
         {
           unsigned short val;
           val = table_get_ushort(t, i, j);
-          table_set_ushort(return_table, i, j, val);
+          table_set_ushort(return_table, row, j, val);
         }
         break;
       case TABLE_LONG:
         {
           long val;
           val = table_get_long(t, i, j);
-          table_set_long(return_table, i, j, val);
+          table_set_long(return_table, row, j, val);
         }
         break;
       case TABLE_ULONG:
         {
           unsigned long val;
           val = table_get_ulong(t, i, j);
-          table_set_ulong(return_table, i, j, val);
+          table_set_ulong(return_table, row, j, val);
         }
         break;
       case TABLE_LLONG:
         {
           long long val;
           val = table_get_llong(t, i, j);
-          table_set_llong(return_table, i, j, val);
+          table_set_llong(return_table, row, j, val);
         }
         break;
       case TABLE_ULLONG:
         {
           unsigned long long val;
           val = table_get_ullong(t, i, j);
-          table_set_ullong(return_table, i, j, val);
+          table_set_ullong(return_table, row, j, val);
         }
         break;
       case TABLE_STRING:
         {
           const char *val;
           val = table_get_string(t, i, j);
-          table_set_string(return_table, i, j, val);
+          table_set_string(return_table, row, j, val);
         }
         break;
       case TABLE_FLOAT:
         {
           float val;
           val = table_get_float(t, i, j);
-          table_set_float(return_table, i, j, val);
+          table_set_float(return_table, row, j, val);
         }
         break;
       case TABLE_DOUBLE:
         {
           double val;
           val = table_get_double(t, i, j);
-          table_set_double(return_table, i, j, val);
+          table_set_double(return_table, row, j, val);
         }
         break;
       case TABLE_LDOUBLE:
         {
           long double val;
           val = table_get_ldouble(t, i, j);
-          table_set_ldouble(return_table, i, j, val);
+          table_set_ldouble(return_table, row, j, val);
         }
         break;
       case TABLE_BOOL:
         {
           bool val;
           val = table_get_bool(t, i, j);
-          table_set_bool(return_table, i, j, val);
+          table_set_bool(return_table, row, j, val);
         }
         break;
       case TABLE_CHAR:
         {
           char val;
           val = table_get_char(t, i, j);
-          table_set_char(return_table, i, j, val);
+          table_set_char(return_table, row, j, val);
         }
         break;
       case TABLE_UCHAR:
         {
           unsigned char val;
           val = table_get_uchar(t, i, j);
-          table_set_uchar(return_table, i, j, val);
+          table_set_uchar(return_table, row, j, val);
         }
         break;
       case TABLE_PTR:
         {
           void* val;
           val = table_get_ptr(t, i, j);
-          table_set_ptr(return_table, i, j, (void*)&val);
+          table_set_ptr(return_table, row, j, (void*)&val);
         }
         break;
       }
@@ -0,0 +1,120 @@
+/**
+ * \file
+ * \brief The table arena implementation file
+ *
+ * This file handles the table arena. When enabled, the row cells and string
+ * values of a table are carved out of large slabs instead of being allocated
+ * individually. Memory handed out by the arena is never freed on its own, it
+ * is released all at once by table_clear() or table_destroy().
+ */
+#include "table_defs.h"
+
+static table_slab *table_arena_add_slab(table *t, size_t size);
+
+/**
+ * \brief Enable or disable the table arena
+ * \param[out] t The table
+ * \param[in] slab_size The size of each slab in bytes, 0 disables the arena
+ * \return 0 on success, or -1 if the table already has rows
+ */
+int table_set_arena(table *t, size_t slab_size)
+{
+  if (table_get_row_length(t))
+    return -1;
+
+  table_arena_destroy(t);
+  t->slab_size = slab_size;
+  return 0;
+}
+
+/**
+ * \brief Get the table arena slab size
+ * \param[in] t The table
+ * \return The size of each slab in bytes, 0 when the arena is disabled
+ */
+size_t table_get_arena(const table *t)
+{
+  return t->slab_size;
+}
+
+/**
+ * \brief Allocate memory from the table arena
+ * \param[out] t The table
+ * \param[in] size The number of bytes to allocate
+ * \param[in] alignment The required alignment, a power of two
+ * \return The allocated memory, or NULL on failure
+ */
+void *table_arena_alloc(table *t, size_t size, size_t alignment)
+{
+  table_slab *slab = t->slabs;
+  uintptr_t address;
+
+  if (slab)
+  {
+    address = ((uintptr_t)(slab->data + slab->used) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    if (address + size <= (uintptr_t)(slab->data + slab->size))
+    {
+      slab->used = address + size - (uintptr_t)slab->data;
+      return (void*)address;
+    }
+  }
+
+  slab = table_arena_add_slab(t, size + alignment > t->slab_size ? size + alignment : t->slab_size);
+  if (!slab)
+    return NULL;
+
+  address = ((uintptr_t)slab->data + alignment - 1) & ~(uintptr_t)(alignment - 1);
+  slab->used = address + size - (uintptr_t)slab->data;
+  return (void*)address;
+}
+
+/**
+ * \brief Release every slab of the table arena
+ * \param[out] t The table
+ */
+void table_arena_destroy(table *t)
+{
+  table_slab *slab = t->slabs;
+
+  while (slab)
+  {
+    table_slab *next = slab->next;
+    free(slab);
+    slab = next;
+  }
+
+  t->slabs = NULL;
+}
+
+/**
+ * \brief Add a slab to the table arena
+ * \param[out] t The table
+ * \param[in] size The usable size of the slab
+ * \return The new slab, or NULL on failure
+ *
+ * Oversized slabs are kept behind the current slab so that its remaining
+ * space is not abandoned.
+ */
+static table_slab *table_arena_add_slab(table *t, size_t size)
+{
+  table_slab *slab = malloc(sizeof(table_slab) + size);
+
+  if (!slab)
+    return NULL;
+
+  slab->size = size;
+  slab->used = 0;
+
+  if (t->slabs && size > t->slab_size)
+  {
+    slab->next = t->slabs->next;
+    t->slabs->next = slab;
+  }
+  else
+  {
+    slab->next = t->slabs;
+    t->slabs = slab;
+  }
+
+  return slab;
+}
@@ -8,8 +8,6 @@
 
 static void table_callback_init(table *t, int callback_index, table_callback func, void *data, table_bitfield event_types);
 static int table_get_callback_index(table *t, table_callback func, void *data);
-static void table_add_callback_block(table *t);
-static void table_remove_callback_block(table *t);
 
 /**
  * \brief Initialize a callback
@@ -48,8 +46,8 @@ void table_register_callback(table *t, table_callback func, void* data, table_bi
     return;
   }
 
-  if(!(t->callbacks_length % t->callbacks_block))
-    table_add_callback_block(t);
+  if((size_t)t->callbacks_length == t->callbacks_allocated)
+    table_resize_callbacks(t, table_grow_capacity(t, t->callbacks_allocated, t->callbacks_block, t->callbacks_allocated + 1));
   
   table_callback_init(t, table_get_callback_length(t), func, data, event_types);
   t->callbacks_length++;
@@ -73,8 +71,8 @@ void table_unregister_callback(table *t, table_callback func, void* data)
       t->callbacks_registration[i] = t->callbacks_registration[i + 1];
     }
 
-    if(!(--t->callbacks_length % t->callbacks_block))
-      table_remove_callback_block(t);
+    t->callbacks_length--;
+    table_resize_callbacks(t, table_shrink_capacity(t, t->callbacks_allocated, t->callbacks_block, 0, t->callbacks_length));
   }
 }
 
@@ -87,23 +85,41 @@ void table_unregister_callback(table *t, table_callback func, void* data)
  */
 void table_notify(table *t, int row_index, int column_index, table_event_type event_type)
 {
+  table_sort_track(t, row_index, column_index, event_type);
+
   for (int callback_index = 0; callback_index < t->callbacks_length; callback_index++)
-    if (t->callbacks_registration[callback_index] & event_type)
-      t->callbacks[callback_index](t, row_index, column_index, event_type, t->callbacks_data[callback_index]);
+  {
+    table_callback callback = t->callbacks[callback_index];
+    void *data = t->callbacks_data[callback_index];
+
+    if (!(t->callbacks_registration[callback_index] & event_type))
+      continue;
+
+    callback(t, row_index, column_index, event_type, data);
+
+    /* A callback that unregistered itself leaves the next one at its index */
+    if (callback_index < t->callbacks_length &&
+        (t->callbacks[callback_index] != callback || t->callbacks_data[callback_index] != data))
+      callback_index--;
+  }
 }
 
 /**
- * \brief Removes a callback block
+ * \brief Reallocate the callbacks of the table
  * \param[in] t The table
+ * \param[in] allocated The number of callbacks to allocate
  */
-static void table_remove_callback_block(table *t)
+void table_resize_callbacks(table *t, size_t allocated)
 {
-  t->callbacks_allocated -= t->callbacks_block;
-  if (t->callbacks_allocated)
+  if (allocated == t->callbacks_allocated)
+    return;
+
+  t->callbacks_allocated = allocated;
+  if (allocated)
   {
-    t->callbacks = realloc(t->callbacks, sizeof(table_callback) * t->callbacks_allocated);
-    t->callbacks_data = realloc(t->callbacks_data, sizeof(void*) * t->callbacks_allocated);
-    t->callbacks_registration = realloc(t->callbacks_registration, sizeof(table_bitfield) * t->callbacks_allocated);
+    t->callbacks = realloc(t->callbacks, sizeof(table_callback) * allocated);
+    t->callbacks_data = realloc(t->callbacks_data, sizeof(void*) * allocated);
+    t->callbacks_registration = realloc(t->callbacks_registration, sizeof(table_bitfield) * allocated);
   }
   else
   {
@@ -116,18 +132,6 @@ static void table_remove_callback_block(table *t)
   }
 }
 
-/**
- * \brief Adds an additional callback block
- * \param[in] t The table
- */
-static void table_add_callback_block(table *t)
-{
-  t->callbacks_allocated += t->callbacks_block;
-  t->callbacks = realloc(t->callbacks, sizeof(table_callback) * t->callbacks_allocated);
-  t->callbacks_data = realloc(t->callbacks_data, sizeof(void*) * t->callbacks_allocated);
-  t->callbacks_registration = realloc(t->callbacks_registration, sizeof(table_bitfield) * t->callbacks_allocated);
-}
-
 /**
  * \brief Get the index of a callback
  * \param[in] t The table
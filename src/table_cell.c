@@ -14,8 +14,15 @@
  */
 void table_cell_init(table *t, int row_index, int column_index)
 {
-  table_cell *cell = table_get_cell_ptr(t, row_index, column_index);
-  cell->value = NULL;
+  table_column *column = table_get_col_ptr(t, column_index);
+
+  table_storage_own_column(t, column_index);
+
+  /* A row that was not widened since the column was added has no cell for it */
+  if (column->storage == TABLE_COLUMN_STORAGE ||
+      (size_t)column->cell_index < table_get_row_ptr(t, row_index)->cells_allocated)
+    memset(table_storage_get_slot(t, row_index, column_index), 0, table_get_data_type_size(column->type));
+  table_storage_set_has_value(t, row_index, column_index, false);
 }
 
 /**
@@ -26,16 +33,13 @@ void table_cell_init(table *t, int row_index, int column_index)
  */
 void table_cell_destroy(table *t, int row_index, int column_index)
 {
-  table_cell *cell = NULL;
-  
   switch (table_get_column_data_type(t, column_index))
   {
-    case TABLE_PTR:
+    case TABLE_STRING:
+      if (!t->slab_size && table_storage_has_value(t, row_index, column_index))
+        free(*(char**)table_storage_get_slot(t, row_index, column_index));
       break;
     default:
-      cell = table_get_cell_ptr(t, row_index, column_index);
-      if(cell->value)
-        free(cell->value);
       break;
   }
 }
@@ -587,7 +591,7 @@ int table_cell_from_buffer(table *t, int row, int col, const char *buf)
 }
 
 /**
- * \brief Free a table cells data and set the ponter to NULL
+ * \brief Free a table cells data and mark it as having no value
  * \param t Table to be acted on
  * \param row The table row
  * \param col The table column
@@ -595,12 +599,8 @@ int table_cell_from_buffer(table *t, int row, int col, const char *buf)
  */
 int table_cell_nullify(table *t, int row, int col)
 {
-  table_cell *cell = table_get_cell_ptr(t, row, col);
-  if (cell->value)
-  {
-    free(cell->value);
-    cell->value = NULL;
-  }
+  table_cell_destroy(t, row, col);
+  table_cell_init(t, row, col);
   return 0;
 }
 
@@ -614,5 +614,6 @@ int table_cell_nullify(table *t, int row, int col)
 table_cell* table_get_cell_ptr(const table *t, int row_index, int column_index)
 {
   table_row *row_ptr = table_get_row_ptr(t, row_index);
-  return row_ptr->cells + column_index;
+  table_column *column = table_get_col_ptr(t, column_index);
+  return row_ptr->cells + column->cell_index;
 }
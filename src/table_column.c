@@ -1,8 +1,6 @@
 #include <string.h>
 #include "table_defs.h"
 
-static void table_add_column_block(table *t);
-static void table_remove_column_block(table *t);
 static int table_column_add(table *t, const char *name, table_data_type data_type);
 static int table_column_remove(table *t, int col_num);
 
@@ -21,6 +19,11 @@ void table_column_init(table *t, int column_index, const char *name, table_data_
 	  strcpy(column->name, name);
   column->type = type;
   column->comparator = func;
+  column->storage = t->storage;
+  column->cell_index = -1;
+  column->data = NULL;
+  column->validity = NULL;
+  column->hash_index = NULL;
 }
 
 /**
@@ -32,6 +35,9 @@ void table_column_destroy(table *t, int column)
   table_column *col = table_get_col_ptr(t, column);
   if (col->name)
     free(col->name);
+
+  table_hash_index_destroy(t, column);
+  table_storage_column_destroy(t, column);
 }
 
 /**
@@ -83,14 +89,100 @@ table_data_type table_get_column_data_type(const table *t, int column_index)
  */
 int table_add_column(table *t, const char* name, table_data_type type)
 {
-  if (!(table_get_column_length(t) % t->column_block))
-    table_add_column_block(t);
+  if ((size_t)table_get_column_length(t) == t->columns_allocated)
+    table_resize_columns(t, table_grow_capacity(t, t->columns_allocated, t->column_block, t->columns_allocated + 1));
 
   table_column_add(t, name, type);
   table_notify(t, -1, table_get_column_length(t), TABLE_COLUMN_ADDED);
   return t->column_length++;
 }
 
+/**
+ * \brief Add several new columns to the table
+ * \param[in] t The table to be acted on
+ * \param[in] names The column names
+ * \param[in] types The column data types
+ * \param[in] length The number of columns
+ * \return The column number of the first new column, or -1 if the length is negative
+ *
+ * The columns are allocated at once and callbacks are notified once every
+ * column has been added.
+ */
+int table_add_columns(table *t, const char **names, const table_data_type *types, int length)
+{
+  int first = table_get_column_length(t);
+
+  if (length < 0)
+    return -1;
+
+  if ((size_t)(first + length) > t->columns_allocated)
+    table_resize_columns(t, table_grow_capacity(t, t->columns_allocated, t->column_block, first + length));
+
+  for (int i = 0; i < length; i++)
+  {
+    table_column_add(t, names[i], types[i]);
+    t->column_length++;
+  }
+
+  for (int i = 0; i < length; i++)
+    table_notify(t, -1, first + i, TABLE_COLUMN_ADDED);
+
+  return first;
+}
+
+/**
+ * \brief Add a new column to the table holding the values of a buffer
+ * \param[in] t The table to be acted on
+ * \param[in] name The column name
+ * \param[in] type The column data type
+ * \param[in] data The values, one per row, which must match the column data type
+ * \param[in] length The number of values
+ * \param[in] ownership Whether the buffer is copied, adopted or borrowed
+ * \return The column number, or -1 if the buffer does not fit the table or memory runs out
+ *
+ * The column always uses column storage. The number of values must match
+ * the number of rows, unless the table has no rows yet, in which case rows
+ * without values are added first. An adopted buffer is freed by the table.
+ * A borrowed buffer must stay alive and unchanged until the column or its
+ * rows are modified, at which point its values are copied. Strings can only be
+ * copied. A NULL pointer leaves its cell without a value. A call that fails
+ * leaves the table as it was.
+ */
+int table_add_column_from_buffer(table *t, const char *name, table_data_type type, void *data, size_t length, table_ownership ownership)
+{
+  table_storage storage = table_get_storage(t);
+  int row_length = table_get_row_length(t);
+  int column_length = table_get_column_length(t);
+
+  if ((row_length && length != (size_t)row_length) || (type == TABLE_STRING && ownership != TABLE_COPY))
+    return -1;
+
+  if (!row_length && length)
+    table_append_rows(t, length);
+
+  if ((size_t)column_length == t->columns_allocated)
+    table_resize_columns(t, table_grow_capacity(t, t->columns_allocated, t->column_block, t->columns_allocated + 1));
+
+  table_set_storage(t, TABLE_COLUMN_STORAGE);
+  table_column_add(t, name, type);
+  table_set_storage(t, storage);
+
+  if (table_storage_column_from_buffer(t, column_length, data, length, ownership))
+  {
+    /* Free the strings copied before the failure */
+    for (int row_index = 0; row_index < table_get_row_length(t); row_index++)
+      table_cell_destroy(t, row_index, column_length);
+    table_column_destroy(t, column_length);
+
+    if (!row_length)
+      table_truncate_rows(t, 0);
+    return -1;
+  }
+
+  table_notify(t, -1, column_length, TABLE_COLUMN_ADDED);
+  return t->column_length++;
+}
+
 /**
  * \brief Delete a column from the table
  * \param[in] t The table to be acted on
@@ -99,11 +191,14 @@ int table_add_column(table *t, const char* name, table_data_type type)
  */
 int table_remove_column(table *t, int col)
 {
+  size_t capacity;
+
   table_column_remove(t, col);
   t->column_length--;
 
-  if (!(table_get_column_length(t) % t->column_block))
-    table_remove_column_block(t);
+  capacity = table_shrink_capacity(t, t->columns_allocated, t->column_block, t->columns_reserved, table_get_column_length(t));
+  if (capacity != t->columns_allocated)
+    table_resize_columns(t, capacity);
 
   table_notify(t, -1, col, TABLE_COLUMN_REMOVED);
   return 0;
@@ -120,42 +215,121 @@ const char* table_get_column_name(const table *t, int col)
 }
 
 /**
- * \brief Remove a block of columns
- * \param[out] table The table to be acted on
+ * \brief Reserve room for a number of columns
+ * \param[out] t The table
+ * \param[in] columns The number of columns to keep allocated
+ * \return 0 on success, or -1 if the number of columns is negative
+ *
+ * When the default storage is row storage, rows are widened to hold the
+ * cells of the additional columns the next time they are written.
  */
-static void table_remove_column_block(table *t)
+int table_reserve_columns(table *t, int columns)
 {
-  int num_rows, row;
+  int column_length = table_get_column_length(t);
+
+  if (columns < 0)
+    return -1;
+
+  t->columns_reserved = columns;
+  if ((size_t)columns > t->columns_allocated)
+    table_resize_columns(t, columns);
+
+  if (t->storage == TABLE_ROW_STORAGE && columns > column_length)
+  {
+    size_t cells = t->cells_length - t->cells_free_length + (columns - column_length);
+    if (cells > t->cells_allocated)
+      t->cells_allocated = cells;
+  }
 
-  t->columns_allocated -= t->column_block;
-  t->columns = realloc(t->columns, sizeof(table_column) * t->columns_allocated);
+  return 0;
+}
+
+/**
+ * \brief Reallocate the columns of the table
+ * \param[out] t The table
+ * \param[in] allocated The number of columns to allocate
+ */
+void table_resize_columns(table *t, size_t allocated)
+{
+  if (allocated == t->columns_allocated)
+    return;
 
-  num_rows = table_get_row_length(t);
-  for (row = 0; row < num_rows; row++)
+  t->columns_allocated = allocated;
+  if (allocated)
+  {
+    t->columns = realloc(t->columns, sizeof(table_column) * allocated);
+  }
+  else
   {
-    table_row *row_ptr = table_get_row_ptr(t, row);
-    row_ptr->cells = realloc(row_ptr->cells, sizeof(table_cell) * t->columns_allocated);
+    free(t->columns);
+    t->columns = NULL;
   }
 }
 
 /**
- * \brief Add a block of columns
- * \param[out] table The table to be acted on
+ * \brief Compact the cells of every row
+ * \param[out] t The table
+ *
+ * The cells of row storage columns are renumbered in column order, dropping
+ * the slots released by removed columns, and every row is reallocated to
+ * exactly that many cells.
  */
-static void table_add_column_block(table *t)
+void table_compact_cells(table *t)
 {
-  int num_rows, row;
+  int column_length = table_get_column_length(t);
+  int row_length = table_get_row_length(t);
+  int cells_length = t->cells_length - t->cells_free_length;
+  int *cell_indexes = NULL;
 
-  t->columns_allocated += t->column_block;
-  t->columns = realloc(t->columns, sizeof(table_column) * t->columns_allocated);
+  if (cells_length)
+    cell_indexes = malloc(sizeof(int) * cells_length);
 
-  num_rows = table_get_row_length(t);
-  for (row = 0; row < num_rows; row++)
+  for (int column_index = 0, cell_index = 0; column_index < column_length; column_index++)
   {
-    table_row *row_ptr = table_get_row_ptr(t, row);
-    row_ptr->cells = realloc(row_ptr->cells, sizeof(table_cell) * t->columns_allocated);
+    table_column *column = table_get_col_ptr(t, column_index);
+    if (column->storage == TABLE_ROW_STORAGE)
+    {
+      cell_indexes[cell_index] = column->cell_index;
+      column->cell_index = cell_index++;
+    }
   }
 
+  for (int row_index = 0; row_index < row_length; row_index++)
+  {
+    table_row *row = table_get_row_ptr(t, row_index);
+    table_cell *cells = NULL;
+
+    if (cells_length)
+    {
+      if (t->slab_size)
+        cells = table_arena_alloc(t, sizeof(table_cell) * cells_length, TABLE_ARENA_ALIGNMENT);
+      else
+        cells = malloc(sizeof(table_cell) * cells_length);
+
+      for (int cell_index = 0; cell_index < cells_length; cell_index++)
+        if ((size_t)cell_indexes[cell_index] < row->cells_allocated)
+          cells[cell_index] = row->cells[cell_indexes[cell_index]];
+        else
+          memset(cells + cell_index, 0, sizeof(table_cell));
+    }
+
+    if (row->cells && !t->slab_size)
+      free(row->cells);
+
+    row->cells = cells;
+    row->cells_allocated = cells_length;
+  }
+
+  if (cell_indexes)
+    free(cell_indexes);
+
+  if (t->cells_free)
+    free(t->cells_free);
+
+  t->cells_free = NULL;
+  t->cells_free_length = 0;
+  t->cells_length = cells_length;
+  t->cells_allocated = cells_length;
 }
 
 /**
@@ -167,14 +341,18 @@ static void table_add_column_block(table *t)
  */
 static int table_column_add(table *t, const char *name, table_data_type type)
 {
-  int row_length = table_get_row_length(t);
   int column_length = table_get_column_length(t);
+  table_column *column;
 
   table_column_init(t, column_length, name, type, table_get_default_comparator_for_data_type(type));
+  column = table_get_col_ptr(t, column_length);
+  table_storage_column_init(t, column_length);
 
-  for(int row = 0; row < row_length; row++)
-    table_cell_init(t, row, column_length);
+  if (column->storage == TABLE_COLUMN_STORAGE)
+    return 0;
 
+  /* Existing rows are left alone, the new column has no values yet */
+  column->cell_index = table_cell_slot_acquire(t);
   return 0;
 }
 
@@ -184,30 +362,70 @@ static int table_column_add(table *t, const char *name, table_data_type type)
  */
 static int table_column_remove(table *t, int column_index)
 {
+  table_column *column = table_get_col_ptr(t, column_index);
+  int column_length = table_get_column_length(t);
+  int row_length = table_get_row_length(t);
+  int cell_index = column->cell_index;
+
+  /* Free the column values, only strings own any memory */
+  if (column->type == TABLE_STRING && !t->slab_size && column->null_count < row_length)
+    for(int i = 0; i < row_length; i++)
+      table_cell_destroy(t, i, column_index);
+
   table_column_destroy(t, column_index);
 
-  int column_length = table_get_column_length(t);
   for(int i = column_index; i < (column_length - 1); i++)
   {
     memcpy(t->columns + i, t->columns + i + 1, sizeof(table_column));
   }
 
-  /* Free extraneous cell values */
-  int row_length = table_get_row_length(t);
-  for(int i = 0; i < row_length; i++)
-  {
-    table_cell_destroy(t, i, column_index);
+  t->generation++;
+  if (cell_index != -1)
+    table_cell_slot_release(t, cell_index);
 
-    /* Shift cells and overwrite deleted cell */
-    table_row* row = table_get_row_ptr(t, i);
-    for(int j = column_index; j < (column_length - 1); j++)
-    {
-      memcpy(row->cells + j, row->cells + j + 1, sizeof(table_cell));
-    }
-  }
   return 0;
 }
 
+/**
+ * \brief Assign a row cell slot to a column
+ * \param[out] t The table
+ * \return The cell index
+ *
+ * Slots released by removed columns are reused first. Rows are widened to
+ * hold a new slot the first time a value is stored in it.
+ */
+int table_cell_slot_acquire(table *t)
+{
+  if (t->cells_free_length)
+    return t->cells_free[--t->cells_free_length];
+
+  if ((size_t)t->cells_length == t->cells_allocated)
+    t->cells_allocated = table_grow_capacity(t, t->cells_allocated, t->column_block, t->cells_allocated + 1);
+
+  return t->cells_length++;
+}
+
+/**
+ * \brief Release the row cell slot of a column
+ * \param[out] t The table
+ * \param[in] cell_index The cell index
+ *
+ * The cell is left in every row and reused by the next row storage column.
+ */
+void table_cell_slot_release(table *t, int cell_index)
+{
+  if (t->cells_free_length == t->cells_length - 1)
+  {
+    t->cells_length = 0;
+    t->cells_free_length = 0;
+  }
+  else
+  {
+    t->cells_free = realloc(t->cells_free, sizeof(int) * (t->cells_free_length + 1));
+    t->cells_free[t->cells_free_length++] = cell_index;
+  }
+}
+
 /**
  * \brief Get the pointer of a particular column
  * \return The table column pointer
@@ -234,4 +452,7 @@ void table_set_column_comparator(table *t, int column, table_comparator function
 {
   table_column *col_ptr = table_get_col_ptr(t, column);
   col_ptr->comparator = function;
+
+  /* The rows may no longer be in order if they were sorted by the column */
+  table_sort_track(t, -1, column, TABLE_DATA_MODIFIED);
 }
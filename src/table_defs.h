@@ -59,17 +59,187 @@
 #define TABLE_ULLONGSF  TABLE_ULLONGF
 #define TABLE_BOOLSF    TABLE_BOOLF
 
+/* Validity bitmaps */
+#define TABLE_BITMAP_WORD_BITS 64
+#define TABLE_BITMAP_WORDS(bits) (((bits) + TABLE_BITMAP_WORD_BITS - 1) / TABLE_BITMAP_WORD_BITS)
+#define TABLE_BITMAP_GET(bitmap, index) (((bitmap)[(index) / TABLE_BITMAP_WORD_BITS] >> ((index) % TABLE_BITMAP_WORD_BITS)) & 1)
+#define TABLE_BITMAP_SET(bitmap, index) ((bitmap)[(index) / TABLE_BITMAP_WORD_BITS] |= (uint64_t)1 << ((index) % TABLE_BITMAP_WORD_BITS))
+#define TABLE_BITMAP_CLEAR(bitmap, index) ((bitmap)[(index) / TABLE_BITMAP_WORD_BITS] &= ~((uint64_t)1 << ((index) % TABLE_BITMAP_WORD_BITS)))
+
+/**
+ * \brief A slab of memory carved up by the table arena
+ */
+struct table_slab
+{
+  table_slab *next; /**< The next slab */
+  size_t size; /**< The usable size of the slab */
+  size_t used; /**< The number of bytes handed out */
+  unsigned char data[]; /**< The slab memory */
+};
+
+#define TABLE_ARENA_ALIGNMENT 16
+
+/**
+ * \brief A hash index of the values of a column
+ *
+ * The rows with a value are kept in an open addressing table with linear
+ * probing. The hash and slot of every row are kept as well, so that a row
+ * can be found in the index once its value has changed.
+ */
+struct table_hash_index
+{
+  table *t; /**< The table indexed */
+  int col; /**< The column indexed */
+  int *slots; /**< The row in each slot, or -1 for an empty slot */
+  int capacity; /**< The number of slots, a power of two */
+  int length; /**< The number of rows in the index */
+  uint64_t *hashes; /**< The hash of the value of each row */
+  int *positions; /**< The slot of each row, or -1 for a row not in the index */
+  int rows_length; /**< The number of rows covered by hashes and positions */
+  int rows_allocated; /**< The number of rows hashes and positions hold */
+};
+
+/**
+ * \brief A block of an ordered index, rows in the order of their values
+ */
+typedef struct table_index_block
+{
+  int length; /**< The number of rows in the block */
+  int rows[]; /**< The rows, ordered by value then by row */
+} table_index_block;
+
+/**
+ * \brief An ordered index of the values of a column
+ *
+ * The rows with a value are kept in order in a list of blocks, each block
+ * found by a binary search on the value of its last row. Every row knows its
+ * block, so that a row can be taken out of the index once its value has
+ * changed.
+ */
+struct table_index
+{
+  table *t; /**< The table indexed, or NULL once it is destroyed */
+  int col; /**< The column indexed, or -1 once it is removed */
+  table_comparator comparator; /**< The comparator the blocks are ordered by */
+  table_index_block **blocks; /**< The blocks, in order */
+  int blocks_length; /**< The number of blocks */
+  int blocks_allocated; /**< The number of blocks allocated */
+  table_index_block **row_blocks; /**< The block of each row, or NULL for a row not in the index */
+  int rows_length; /**< The number of rows covered by row_blocks */
+  int rows_allocated; /**< The number of rows row_blocks holds */
+  int length; /**< The number of rows in the index */
+};
+
+/* The value of a row of a column storage view, strings and pointers are dereferenced */
+#define TABLE_VIEW_VALUE(view, index) ((view)->type == TABLE_STRING || (view)->type == TABLE_PTR ? \
+  *(void**)((char*)(view)->base + (view)->stride * (index)) : (void*)((char*)(view)->base + (view)->stride * (index)))
+
+/* The slot of a row of a column, read from a column storage view when there is one */
+#define TABLE_KERNEL_SLOT(t, view, row_index, column_index) ((view)->base ? \
+  (const void*)((const char*)(view)->base + (view)->stride * (row_index)) : (const void*)table_storage_get_slot(t, row_index, column_index))
+
+/*
+ * The data types with kernels specialised for their default comparator, as
+ * X(name, C type, data type, kind). The kind names the macros that read a
+ * search value of the type and compare two values of the type.
+ */
+#define TABLE_KERNEL_TYPES(X) \
+  X(int, int, TABLE_INT, TABLE_KERNEL_NUMBER) \
+  X(uint, unsigned int, TABLE_UINT, TABLE_KERNEL_NUMBER) \
+  X(int8, int8_t, TABLE_INT8, TABLE_KERNEL_NUMBER) \
+  X(uint8, uint8_t, TABLE_UINT8, TABLE_KERNEL_NUMBER) \
+  X(int16, int16_t, TABLE_INT16, TABLE_KERNEL_NUMBER) \
+  X(uint16, uint16_t, TABLE_UINT16, TABLE_KERNEL_NUMBER) \
+  X(int32, int32_t, TABLE_INT32, TABLE_KERNEL_NUMBER) \
+  X(uint32, uint32_t, TABLE_UINT32, TABLE_KERNEL_NUMBER) \
+  X(int64, int64_t, TABLE_INT64, TABLE_KERNEL_NUMBER) \
+  X(uint64, uint64_t, TABLE_UINT64, TABLE_KERNEL_NUMBER) \
+  X(short, short, TABLE_SHORT, TABLE_KERNEL_NUMBER) \
+  X(ushort, unsigned short, TABLE_USHORT, TABLE_KERNEL_NUMBER) \
+  X(long, long, TABLE_LONG, TABLE_KERNEL_NUMBER) \
+  X(ulong, unsigned long, TABLE_ULONG, TABLE_KERNEL_NUMBER) \
+  X(llong, long long, TABLE_LLONG, TABLE_KERNEL_NUMBER) \
+  X(ullong, unsigned long long, TABLE_ULLONG, TABLE_KERNEL_NUMBER) \
+  X(float, float, TABLE_FLOAT, TABLE_KERNEL_NUMBER) \
+  X(double, double, TABLE_DOUBLE, TABLE_KERNEL_NUMBER) \
+  X(ldouble, long double, TABLE_LDOUBLE, TABLE_KERNEL_NUMBER) \
+  X(bool, bool, TABLE_BOOL, TABLE_KERNEL_NUMBER) \
+  X(char, char, TABLE_CHAR, TABLE_KERNEL_NUMBER) \
+  X(uchar, unsigned char, TABLE_UCHAR, TABLE_KERNEL_NUMBER) \
+  X(string, const char*, TABLE_STRING, TABLE_KERNEL_STRING)
+
+#define TABLE_KERNEL_NUMBER_LOAD(type, value) (*(const type*)(value))
+#define TABLE_KERNEL_NUMBER_COMPARE(value1, value2) (((value1) > (value2)) - ((value1) < (value2)))
+#define TABLE_KERNEL_STRING_LOAD(type, value) ((type)(value))
+#define TABLE_KERNEL_STRING_COMPARE(value1, value2) strcmp(value1, value2)
+
 /* Internal constructors */
 void table_row_init(table *t, int row_index);
 void table_column_init(table *t, int column_index, const char *name, table_data_type type, table_comparator func);
 void table_cell_init(table *t, int row_index, int column_index);
+void table_row_widen(table *t, int row_index);
 
 /* Internal destructors */
 void table_row_destroy(table *t, int row_index);
+void table_truncate_rows(table *t, int length);
 void table_column_destroy(table *t, int column_index);
 void table_cell_destroy(table* t, int row_index, int column_index);
 
+/* Internal storage */
+size_t table_get_data_type_size(table_data_type type);
+void table_storage_column_init(table *t, int column_index);
+void table_storage_column_destroy(table *t, int column_index);
+int table_storage_column_from_buffer(table *t, int column_index, void *data, size_t length, table_ownership ownership);
+void table_storage_own_column(table *t, int column_index);
+void table_storage_get_view(const table *t, int column_index, table_column_view *view);
+int table_cell_slot_acquire(table *t);
+void table_cell_slot_release(table *t, int cell_index);
+void table_storage_resize_rows(table *t, size_t previous_allocated);
+void table_storage_remove_row(table *t, int row_index);
+void table_storage_compact_rows(table *t);
+void table_storage_permute_rows(table *t, int first, const int *order, int length);
+void *table_storage_get_slot(const table *t, int row_index, int column_index);
+bool table_storage_has_value(const table *t, int row_index, int column_index);
+void table_storage_set_has_value(table *t, int row_index, int column_index, bool has_value);
+void *table_storage_get_value(const table *t, int row_index, int column_index);
+void *table_storage_get(const table *t, int row_index, int column_index);
+int table_storage_set(table *t, int row_index, int column_index, void *value);
+int table_storage_set_range(table *t, int first_row, int column_index, int length, const char *values, size_t stride);
+uint64_t table_string_prefix(const char *value);
+const uint64_t *table_storage_get_prefixes(const table *t, int column_index, bool cache);
+
+/* Internal growth */
+size_t table_grow_capacity(const table *t, size_t allocated, size_t block, size_t required);
+size_t table_shrink_capacity(const table *t, size_t allocated, size_t block, size_t reserved, size_t length);
+void table_resize_rows(table *t, size_t allocated);
+void table_resize_columns(table *t, size_t allocated);
+void table_compact_cells(table *t);
+void table_resize_callbacks(table *t, size_t allocated);
+
+/* Internal arena */
+void *table_arena_alloc(table *t, size_t size, size_t alignment);
+void table_arena_destroy(table *t);
+
+/* Internal sort */
+typedef struct table_sort_context table_sort_context;
+table_sort_context *table_sort_context_create(const table *t, const table_sort_spec *spec);
+void table_sort_context_destroy(table_sort_context *context);
+void table_sort_context_argsort(const table_sort_context *context, int *rows, int *scratch, int length);
+int table_sort_context_compare(const table_sort_context *context, int row1, int row2);
+void table_sort_apply(table *t, const table_sort_spec *spec, const int *order);
+
+/* Internal hash indexes */
+void table_hash_index_destroy(table *t, int col);
+int table_hash_index_find(const table_hash_index *index, const void *value, table_order order, int minimum_index, int maximum_index);
+int table_hash_index_find_all(const table_hash_index *index, const void *value, int minimum_index, int maximum_index,
+                              int limit, table_selection *out);
+
+/* Internal selections */
+void table_selection_reset(table_selection *selection, const table *t);
+int table_selection_add(table_selection *selection, int row);
+
 /* Internal event notifier */
+void table_sort_track(table *t, int row_index, int column_index, table_event_type event_type);
 void table_notify(table* t, int row_index, int column_index, table_event_type event_type);
 
 /* Internal structure getters/setters */
@@ -77,5 +247,6 @@ table_cell *table_get_cell_ptr(const table *t, int row_index, int column_index);
 table_column *table_get_col_ptr(const table *t, int col_num);
 table_row *table_get_row_ptr(const table *t, int row_num);
 void table_set_row_ptr(table *t, int row, table_row *row_ptr);
+void table_permute_rows(table *t, int first, const int *order, int length);
 
 #endif
@@ -0,0 +1,552 @@
+/**
+ * \file
+ * \brief The table external sort implementation file
+ *
+ * This file handles sorting a table within a memory budget. The row indices
+ * are sorted in runs that fit in the budget, each sorted run is spilled to a
+ * temporary file, and the runs are merged back by a k-way merge that keeps
+ * the head of every run in a heap. When there are too many runs to merge at
+ * once, groups of runs are merged into longer runs first. Only row indices
+ * are written out, the values are compared in the table itself with its
+ * comparators, so the sort works on every column type.
+ */
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include "table_defs.h"
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+static const size_t EXTERNAL_SORT_DEFAULT_BUDGET = (size_t)64 << 20;
+static const int EXTERNAL_SORT_MIN_RUN = 256;
+static const int EXTERNAL_SORT_MIN_BUFFER = 256;
+static const int EXTERNAL_SORT_MAX_FAN_IN = 64;
+
+/**
+ * \brief A function receiving the rows of a merge in sort order
+ */
+typedef int (*table_sort_output)(void *data, int row);
+
+/**
+ * \brief A sorted run of row indices spilled to a temporary file
+ */
+typedef struct table_sort_run
+{
+  FILE *file; /**< The temporary file holding the run */
+  int length; /**< The number of rows of the run not read back yet */
+  int *buffer; /**< The rows of the run read back */
+  int allocated; /**< The number of rows the buffer holds */
+  int buffered; /**< The number of rows in the buffer */
+  int position; /**< The index of the next row in the buffer */
+} table_sort_run;
+
+/**
+ * \brief The destination of an external sort to a stream
+ */
+typedef struct table_sort_stream
+{
+  const table *t; /**< The table sorted */
+  FILE *stream; /**< The stream the rows are written to */
+} table_sort_stream;
+
+static size_t table_external_sort_budget(const table_external_sort_options *options);
+static int table_external_sort_rows(const table *t, const table_sort_spec *spec,
+                                    const table_external_sort_options *options, table_sort_output output, void *data);
+static int table_external_sort_runs(const table *t, const table_sort_context *context,
+                                    const table_external_sort_options *options, table_sort_run **runs, int *num_runs);
+static int table_external_sort_reduce(const table_sort_context *context, const table_external_sort_options *options,
+                                      table_sort_run *runs, int *num_runs);
+static int table_external_sort_merge(const table_sort_context *context, table_sort_run *runs, int num_runs,
+                                     size_t budget, table_sort_output output, void *data);
+static bool table_external_sort_before(const table_sort_context *context, const table_sort_run *runs, int run1, int run2);
+static void table_external_sort_sift_down(const table_sort_context *context, const table_sort_run *runs,
+                                          int *heap, int length, int index);
+static int table_sort_run_fill(table_sort_run *run);
+static void table_sort_runs_close(table_sort_run *runs, int num_runs);
+static FILE *table_external_sort_temp_file(const char *dir);
+static int table_external_sort_to_order(void *data, int row);
+static int table_external_sort_to_run(void *data, int row);
+static int table_external_sort_to_stream(void *data, int row);
+
+/**
+ * \brief Sort the table by a sort specification within a memory budget
+ * \param[in] t The table to be sorted
+ * \param[in] spec The sort specification
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \return 0 on success, or -1 if a temporary file could not be created, written or read
+ *
+ * The rows end up in exactly the same order as with table_sort(). Moving the
+ * rows takes a row index per row on top of the budget. The table is left as
+ * it is on failure.
+ */
+int table_sort_external(table *t, const table_sort_spec *spec, const table_external_sort_options *options)
+{
+  int num_rows = table_get_row_length(t);
+  int *order = malloc((num_rows ? num_rows : 1) * sizeof(int));
+  int *next = order;
+  int rc;
+
+  if (!order)
+    return -1;
+
+  rc = table_external_sort_rows(t, spec, options, table_external_sort_to_order, &next);
+  if (!rc)
+    table_sort_apply(t, spec, order);
+
+  free(order);
+  return rc;
+}
+
+/**
+ * \brief Write the rows of a table to a stream in sort order within a memory budget
+ * \param[in] t The table
+ * \param[in] spec The sort specification
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \param[out] stream The stream to write to
+ * \return 0 on success, or -1 if a temporary file or the stream could not be written or read
+ *
+ * Each row is written as a line of its cells in the format of
+ * table_cell_to_buffer(), separated by tabs, with cells without a value left
+ * empty. The table is left as it is.
+ */
+int table_sort_external_to_stream(const table *t, const table_sort_spec *spec,
+                                  const table_external_sort_options *options, FILE *stream)
+{
+  table_sort_stream destination = { t, stream };
+
+  return table_external_sort_rows(t, spec, options, table_external_sort_to_stream, &destination);
+}
+
+/**
+ * \brief Get the memory budget of an external sort
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \return The memory budget in bytes
+ */
+static size_t table_external_sort_budget(const table_external_sort_options *options)
+{
+  if (!options || !options->memory_budget)
+    return EXTERNAL_SORT_DEFAULT_BUDGET;
+
+  return options->memory_budget;
+}
+
+/**
+ * \brief Pass every row of a table to an output in sort order
+ * \param[in] t The table
+ * \param[in] spec The sort specification
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \param[in] output The function receiving the rows
+ * \param[in] data The data passed to the output
+ * \return 0 on success, or -1 on failure
+ */
+static int table_external_sort_rows(const table *t, const table_sort_spec *spec,
+                                    const table_external_sort_options *options, table_sort_output output, void *data)
+{
+  int num_rows = table_get_row_length(t);
+  table_sort_context *context;
+  table_sort_run *runs = NULL;
+  int num_runs = 0, rc;
+
+  if (num_rows < 2 || spec->length < 1)
+  {
+    for (int row = 0; row < num_rows; row++)
+    {
+      if (output(data, row))
+        return -1;
+    }
+    return 0;
+  }
+
+  context = table_sort_context_create(t, spec);
+  if (!context)
+    return -1;
+
+  rc = table_external_sort_runs(t, context, options, &runs, &num_runs);
+  if (!rc)
+    rc = table_external_sort_reduce(context, options, runs, &num_runs);
+  if (!rc)
+    rc = table_external_sort_merge(context, runs, num_runs, table_external_sort_budget(options), output, data);
+
+  table_sort_runs_close(runs, num_runs);
+  free(runs);
+  table_sort_context_destroy(context);
+  return rc;
+}
+
+/**
+ * \brief Sort the rows of a table in runs and spill each run to a temporary file
+ * \param[in] t The table
+ * \param[in] context The sort context
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \param[out] runs Set to the sorted runs, in row order
+ * \param[out] num_runs Set to the number of sorted runs
+ * \return 0 on success, or -1 on failure
+ *
+ * A run holds as many rows as the budget allows for the row indices, a
+ * scratch buffer and the radix keys of a sort.
+ */
+static int table_external_sort_runs(const table *t, const table_sort_context *context,
+                                    const table_external_sort_options *options, table_sort_run **runs, int *num_runs)
+{
+  int num_rows = table_get_row_length(t);
+  size_t run_size = table_external_sort_budget(options) / (2 * sizeof(int) + 2 * sizeof(uint64_t));
+  int run_length = run_size < (size_t)num_rows ? (int)run_size : num_rows;
+  int *rows, *scratch;
+  int rc = 0;
+
+  if (run_length < EXTERNAL_SORT_MIN_RUN)
+    run_length = EXTERNAL_SORT_MIN_RUN;
+
+  *num_runs = 0;
+  *runs = calloc((num_rows + run_length - 1) / run_length, sizeof(table_sort_run));
+  rows = malloc(run_length * sizeof(int));
+  scratch = malloc(run_length * sizeof(int));
+  if (!*runs || !rows || !scratch)
+    rc = -1;
+
+  for (int first = 0; !rc && first < num_rows; first += run_length)
+  {
+    table_sort_run *run = &(*runs)[*num_runs];
+    int length = num_rows - first < run_length ? num_rows - first : run_length;
+
+    for (int i = 0; i < length; i++)
+      rows[i] = first + i;
+
+    table_sort_context_argsort(context, rows, scratch, length);
+
+    run->file = table_external_sort_temp_file(options ? options->temp_dir : NULL);
+    if (!run->file)
+    {
+      rc = -1;
+      break;
+    }
+
+    run->length = length;
+    (*num_runs)++;
+
+    if (fwrite(rows, sizeof(int), length, run->file) != (size_t)length)
+      rc = -1;
+  }
+
+  free(scratch);
+  free(rows);
+  return rc;
+}
+
+/**
+ * \brief Merge groups of runs into longer runs until they can be merged at once
+ * \param[in] context The sort context
+ * \param[in] options The external sort options, or NULL for the defaults
+ * \param[in,out] runs The sorted runs, in row order
+ * \param[in,out] num_runs The number of sorted runs
+ * \return 0 on success, or -1 on failure
+ *
+ * Groups of consecutive runs are merged, so equal rows keep their order.
+ */
+static int table_external_sort_reduce(const table_sort_context *context, const table_external_sort_options *options,
+                                      table_sort_run *runs, int *num_runs)
+{
+  size_t budget = table_external_sort_budget(options);
+
+  while (*num_runs > EXTERNAL_SORT_MAX_FAN_IN)
+  {
+    int merged = 0;
+
+    for (int first = 0; first < *num_runs; first += EXTERNAL_SORT_MAX_FAN_IN)
+    {
+      int length = *num_runs - first < EXTERNAL_SORT_MAX_FAN_IN ? *num_runs - first : EXTERNAL_SORT_MAX_FAN_IN;
+      table_sort_run run = { NULL, 0, NULL, 0, 0, 0 };
+      int rc;
+
+      for (int i = first; i < first + length; i++)
+        run.length += runs[i].length;
+
+      run.file = table_external_sort_temp_file(options ? options->temp_dir : NULL);
+      if (!run.file)
+        rc = -1;
+      else
+        rc = table_external_sort_merge(context, runs + first, length, budget, table_external_sort_to_run, run.file);
+
+      table_sort_runs_close(runs + first, length);
+      if (rc)
+      {
+        if (run.file)
+          fclose(run.file);
+        table_sort_runs_close(runs, merged);
+        table_sort_runs_close(runs + first + length, *num_runs - first - length);
+        *num_runs = 0;
+        return -1;
+      }
+
+      runs[merged++] = run;
+    }
+
+    *num_runs = merged;
+  }
+
+  return 0;
+}
+
+/**
+ * \brief Merge sorted runs into an output
+ * \param[in] context The sort context
+ * \param[in,out] runs The sorted runs, in row order
+ * \param[in] num_runs The number of sorted runs
+ * \param[in] budget The memory budget, shared by the read buffers of the runs
+ * \param[in] output The function receiving the merged rows
+ * \param[in] data The data passed to the output
+ * \return 0 on success, or -1 on failure
+ */
+static int table_external_sort_merge(const table_sort_context *context, table_sort_run *runs, int num_runs,
+                                     size_t budget, table_sort_output output, void *data)
+{
+  size_t buffer_size = budget / (num_runs * sizeof(int));
+  int buffer_length = buffer_size < (size_t)EXTERNAL_SORT_MIN_BUFFER ? EXTERNAL_SORT_MIN_BUFFER :
+                      buffer_size > (size_t)INT32_MAX ? INT32_MAX : (int)buffer_size;
+  int *heap = malloc(num_runs * sizeof(int));
+  int *buffers;
+  int longest = 1, length = 0, rc = 0, i;
+
+  for (i = 0; i < num_runs; i++)
+  {
+    if (runs[i].length > longest)
+      longest = runs[i].length;
+  }
+
+  if (buffer_length > longest)
+    buffer_length = longest;
+
+  buffers = malloc((size_t)num_runs * buffer_length * sizeof(int));
+  if (!heap || !buffers)
+  {
+    free(buffers);
+    free(heap);
+    return -1;
+  }
+
+  for (i = 0; i < num_runs && !rc; i++)
+  {
+    table_sort_run *run = &runs[i];
+
+    run->buffer = buffers + (size_t)i * buffer_length;
+    run->allocated = buffer_length;
+    run->buffered = 0;
+    run->position = 0;
+    rewind(run->file);
+
+    rc = table_sort_run_fill(run);
+    if (rc > 0)
+    {
+      heap[length++] = i;
+      rc = 0;
+    }
+  }
+
+  for (i = length / 2 - 1; i >= 0; i--)
+    table_external_sort_sift_down(context, runs, heap, length, i);
+
+  while (length && !rc)
+  {
+    table_sort_run *run = &runs[heap[0]];
+
+    rc = output(data, run->buffer[run->position++]);
+
+    if (run->position == run->buffered)
+    {
+      int filled = table_sort_run_fill(run);
+      if (filled < 0)
+        rc = -1;
+      else if (!filled)
+        heap[0] = heap[--length];
+    }
+
+    table_external_sort_sift_down(context, runs, heap, length, 0);
+  }
+
+  for (i = 0; i < num_runs; i++)
+    runs[i].buffer = NULL;
+
+  free(buffers);
+  free(heap);
+  return rc;
+}
+
+/**
+ * \brief Determine if the next row of a run is merged before the next row of another
+ * \param[in] context The sort context
+ * \param[in] runs The sorted runs
+ * \param[in] run1 The first run
+ * \param[in] run2 The second run
+ * \return TRUE or FALSE, equal rows are taken from the earlier run first
+ */
+static bool table_external_sort_before(const table_sort_context *context, const table_sort_run *runs, int run1, int run2)
+{
+  int result = table_sort_context_compare(context, runs[run1].buffer[runs[run1].position],
+                                          runs[run2].buffer[runs[run2].position]);
+
+  return result < 0 || (!result && run1 < run2);
+}
+
+/**
+ * \brief Move a run down the merge heap until the runs below it are merged later
+ * \param[in] context The sort context
+ * \param[in] runs The sorted runs
+ * \param[in,out] heap The merge heap, the run merged next at the top
+ * \param[in] length The number of runs in the heap
+ * \param[in] index The index of the run to move down
+ */
+static void table_external_sort_sift_down(const table_sort_context *context, const table_sort_run *runs,
+                                          int *heap, int length, int index)
+{
+  for (;;)
+  {
+    int child = 2 * index + 1, run;
+
+    if (child >= length)
+      return;
+
+    if (child + 1 < length && table_external_sort_before(context, runs, heap[child + 1], heap[child]))
+      child++;
+
+    if (!table_external_sort_before(context, runs, heap[child], heap[index]))
+      return;
+
+    run = heap[index];
+    heap[index] = heap[child];
+    heap[child] = run;
+    index = child;
+  }
+}
+
+/**
+ * \brief Read the next rows of a run back into its buffer
+ * \param[in,out] run The sorted run
+ * \return 1 if rows were read, 0 if the run is exhausted, or -1 on failure
+ */
+static int table_sort_run_fill(table_sort_run *run)
+{
+  int length = run->length < run->allocated ? run->length : run->allocated;
+
+  if (!length)
+    return 0;
+
+  if (fread(run->buffer, sizeof(int), length, run->file) != (size_t)length)
+    return -1;
+
+  run->length -= length;
+  run->buffered = length;
+  run->position = 0;
+  return 1;
+}
+
+/**
+ * \brief Close the temporary files of sorted runs
+ * \param[in,out] runs The sorted runs
+ * \param[in] num_runs The number of sorted runs
+ */
+static void table_sort_runs_close(table_sort_run *runs, int num_runs)
+{
+  for (int i = 0; i < num_runs; i++)
+  {
+    if (runs[i].file)
+      fclose(runs[i].file);
+    runs[i].file = NULL;
+  }
+}
+
+/**
+ * \brief Create a temporary file, removed once it is closed
+ * \param[in] dir The directory of the file, or NULL for the system default
+ * \return The file opened for update, or NULL on failure
+ */
+static FILE *table_external_sort_temp_file(const char *dir)
+{
+  FILE *file = NULL;
+  char *path;
+
+  if (!dir)
+    return tmpfile();
+
+#ifdef _WIN32
+  path = _tempnam(dir, "table-sort-");
+  if (path)
+    file = fopen(path, "w+bD");
+#else
+  size_t size = strlen(dir) + sizeof("/table-sort-XXXXXX");
+  int fd;
+
+  path = malloc(size);
+  if (!path)
+    return NULL;
+
+  snprintf(path, size, "%s/table-sort-XXXXXX", dir);
+  fd = mkstemp(path);
+  if (fd >= 0)
+  {
+    file = fdopen(fd, "w+b");
+    if (!file)
+      close(fd);
+    remove(path);
+  }
+#endif
+
+  free(path);
+  return file;
+}
+
+/**
+ * \brief Append a merged row to a sort order
+ * \param[in,out] data A pointer to the next entry of the sort order
+ * \param[in] row The table row
+ * \return 0
+ */
+static int table_external_sort_to_order(void *data, int row)
+{
+  int **next = data;
+
+  *(*next)++ = row;
+  return 0;
+}
+
+/**
+ * \brief Append a merged row to a run
+ * \param[in,out] data The file of the run
+ * \param[in] row The table row
+ * \return 0 on success, or -1 on failure
+ */
+static int table_external_sort_to_run(void *data, int row)
+{
+  return fwrite(&row, sizeof(int), 1, data) == 1 ? 0 : -1;
+}
+
+/**
+ * \brief Write a merged row to a stream
+ * \param[in,out] data The stream destination
+ * \param[in] row The table row
+ * \return 0 on success, or -1 on failure
+ */
+static int table_external_sort_to_stream(void *data, int row)
+{
+  table_sort_stream *destination = data;
+  const table *t = destination->t;
+  int num_cols = table_get_column_length(t);
+  char buf[512];
+
+  for (int col = 0; col < num_cols; col++)
+  {
+    if (col)
+      fputc('\t', destination->stream);
+
+    if (!table_cell_has_value(t, row, col))
+      continue;
+
+    if (table_get_column_data_type(t, col) == TABLE_STRING)
+      fputs(table_get_string(t, row, col), destination->stream);
+    else if (!table_cell_to_buffer(t, row, col, buf, sizeof(buf)))
+      fputs(buf, destination->stream);
+  }
+
+  fputc('\n', destination->stream);
+  return ferror(destination->stream) ? -1 : 0;
+}
@@ -4,8 +4,336 @@
  * 
  * This file handles table find implementations.
  */
+#include <limits.h>
 #include "table_defs.h"
 
+/*
+ * Vector equality compares for the scan of dense column storage, each
+ * producing a mask with one bit per byte of the vector. Floating point
+ * values also match when unordered, like the scalar kernels.
+ */
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TABLE_FIND_SIMD
+typedef __m256i table_simd;
+#define TABLE_SIMD_BYTES 32
+#define TABLE_SIMD_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define TABLE_SIMD_MASK(v) ((uint32_t)_mm256_movemask_epi8(v))
+#define TABLE_SIMD_EQ_8(a, b) _mm256_cmpeq_epi8(a, b)
+#define TABLE_SIMD_EQ_16(a, b) _mm256_cmpeq_epi16(a, b)
+#define TABLE_SIMD_EQ_32(a, b) _mm256_cmpeq_epi32(a, b)
+#define TABLE_SIMD_EQ_64(a, b) _mm256_cmpeq_epi64(a, b)
+#define TABLE_SIMD_EQ_FLOAT(a, b) \
+  _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(a), _mm256_castsi256_ps(b), _CMP_EQ_UQ))
+#define TABLE_SIMD_EQ_DOUBLE(a, b) \
+  _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(a), _mm256_castsi256_pd(b), _CMP_EQ_UQ))
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define TABLE_FIND_SIMD
+typedef __m128i table_simd;
+#define TABLE_SIMD_BYTES 16
+#define TABLE_SIMD_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define TABLE_SIMD_MASK(v) ((uint32_t)_mm_movemask_epi8(v))
+#define TABLE_SIMD_EQ_8(a, b) _mm_cmpeq_epi8(a, b)
+#define TABLE_SIMD_EQ_16(a, b) _mm_cmpeq_epi16(a, b)
+#define TABLE_SIMD_EQ_32(a, b) _mm_cmpeq_epi32(a, b)
+#define TABLE_SIMD_EQ_64(a, b) table_simd_eq_64(a, b)
+#define TABLE_SIMD_EQ_FLOAT(a, b) table_simd_eq_float(_mm_castsi128_ps(a), _mm_castsi128_ps(b))
+#define TABLE_SIMD_EQ_DOUBLE(a, b) table_simd_eq_double(_mm_castsi128_pd(a), _mm_castsi128_pd(b))
+
+/* SSE2 has no 64 bit compare, both halves of a value have to match */
+static inline __m128i table_simd_eq_64(__m128i a, __m128i b)
+{
+  __m128i halves = _mm_cmpeq_epi32(a, b);
+  return _mm_and_si128(halves, _mm_shuffle_epi32(halves, _MM_SHUFFLE(2, 3, 0, 1)));
+}
+
+static inline __m128i table_simd_eq_float(__m128 a, __m128 b)
+{
+  return _mm_castps_si128(_mm_or_ps(_mm_cmpeq_ps(a, b), _mm_cmpunord_ps(a, b)));
+}
+
+static inline __m128i table_simd_eq_double(__m128d a, __m128d b)
+{
+  return _mm_castpd_si128(_mm_or_pd(_mm_cmpeq_pd(a, b), _mm_cmpunord_pd(a, b)));
+}
+#endif
+
+static int table_subset_find_valid(const table *t, int column_index, void *value, table_order order, int minimum_index, int maximum_index);
+static int table_subset_find_all_valid(const table *t, int column_index, void *value, int minimum_index, int maximum_index,
+                                       int limit, table_selection *out);
+static inline void *table_find_get_value(const table *t, const table_column_view *view, int row_index, int column_index);
+static table_order table_sorted_order(const table *t, int column_index);
+static int table_sorted_bound(const table *t, int column_index, void *value, table_order order, table_position position,
+                              int minimum, int maximum);
+static int table_sorted_bound_prefix(const table *t, const table_column *column, const uint64_t *prefixes, int column_index,
+                                     const char *value, int sign, table_position position, int minimum, int maximum);
+
+#ifdef TABLE_FIND_SIMD
+static bool table_find_simd_supported(const table_column_view *view);
+static table_simd table_find_simd_needle(const void *value, size_t size);
+static int table_find_simd(const table_column_view *view, const void *value, table_order order, int *minimum_index, int *maximum_index);
+static int table_find_all_simd(const table_column_view *view, const void *value, int *minimum_index, int maximum_index,
+                               int count, int limit, table_selection *out);
+#endif
+
+static const int PREFIX_SEARCH_CUTOFF = 64;
+
+/*
+ * Scan the rows from minimum_index to maximum_index that have a value in the
+ * given order, returning the first row_index for which MATCH holds. Dense
+ * columns are scanned without any validity checks, otherwise the validity
+ * bitmap is walked a word at a time so that runs of 64 rows without a value
+ * are skipped at once.
+ */
+#define TABLE_FIND_SCAN(MATCH)                                                                                  \
+do                                                                                                              \
+{                                                                                                               \
+  const uint64_t *validity = column->validity;                                                                  \
+                                                                                                                \
+  if (!column->null_count)                                                                                      \
+  {                                                                                                             \
+    if (order == TABLE_ASCENDING)                                                                               \
+    {                                                                                                           \
+      for (int row_index = minimum_index; row_index <= maximum_index; row_index++)                              \
+        if (MATCH)                                                                                              \
+          return row_index;                                                                                     \
+    }                                                                                                           \
+    else                                                                                                        \
+    {                                                                                                           \
+      for (int row_index = maximum_index; row_index >= minimum_index; row_index--)                              \
+        if (MATCH)                                                                                              \
+          return row_index;                                                                                     \
+    }                                                                                                           \
+    return TABLE_INDEX_NOT_FOUND;                                                                               \
+  }                                                                                                             \
+                                                                                                                \
+  if (order == TABLE_ASCENDING)                                                                                 \
+  {                                                                                                             \
+    for (int row_index = minimum_index; row_index <= maximum_index; row_index++)                                \
+    {                                                                                                           \
+      if (!validity[row_index / TABLE_BITMAP_WORD_BITS] && !(row_index % TABLE_BITMAP_WORD_BITS))               \
+      {                                                                                                         \
+        row_index += TABLE_BITMAP_WORD_BITS - 1;                                                                \
+        continue;                                                                                               \
+      }                                                                                                         \
+      if (TABLE_BITMAP_GET(validity, row_index) && (MATCH))                                                     \
+        return row_index;                                                                                       \
+    }                                                                                                           \
+  }                                                                                                             \
+  else                                                                                                          \
+  {                                                                                                             \
+    for (int row_index = maximum_index; row_index >= minimum_index; row_index--)                                \
+    {                                                                                                           \
+      if (!validity[row_index / TABLE_BITMAP_WORD_BITS] &&                                                      \
+          row_index % TABLE_BITMAP_WORD_BITS == TABLE_BITMAP_WORD_BITS - 1)                                     \
+      {                                                                                                         \
+        row_index -= TABLE_BITMAP_WORD_BITS - 1;                                                                \
+        continue;                                                                                               \
+      }                                                                                                         \
+      if (TABLE_BITMAP_GET(validity, row_index) && (MATCH))                                                     \
+        return row_index;                                                                                       \
+    }                                                                                                           \
+  }                                                                                                             \
+                                                                                                                \
+  return TABLE_INDEX_NOT_FOUND;                                                                                 \
+} while (0)
+
+/*
+ * Scan the rows from minimum_index to maximum_index that have a value in
+ * ascending order, adding every row_index for which MATCH holds to the
+ * selection out, if any, until count reaches limit. Returns the count.
+ */
+#define TABLE_FIND_ALL_SCAN(MATCH)                                                                              \
+do                                                                                                              \
+{                                                                                                               \
+  const uint64_t *validity = column->validity;                                                                  \
+                                                                                                                \
+  for (int row_index = minimum_index; row_index <= maximum_index; row_index++)                                  \
+  {                                                                                                             \
+    if (column->null_count)                                                                                     \
+    {                                                                                                           \
+      if (!validity[row_index / TABLE_BITMAP_WORD_BITS] && !(row_index % TABLE_BITMAP_WORD_BITS))               \
+      {                                                                                                         \
+        row_index += TABLE_BITMAP_WORD_BITS - 1;                                                                \
+        continue;                                                                                               \
+      }                                                                                                         \
+      if (!TABLE_BITMAP_GET(validity, row_index))                                                               \
+        continue;                                                                                               \
+    }                                                                                                           \
+    if (MATCH)                                                                                                  \
+    {                                                                                                           \
+      if (out && table_selection_add(out, row_index))                                                           \
+        return -1;                                                                                              \
+      if (++count == limit)                                                                                     \
+        break;                                                                                                  \
+    }                                                                                                           \
+  }                                                                                                             \
+                                                                                                                \
+  return count;                                                                                                 \
+} while (0)
+
+/*
+ * Scan whole vectors of the rows from minimum_index to maximum_index of a
+ * dense view in the given order, where EQ compares a vector of values to the
+ * needle. Every lane that matches is checked against the validity bitmap.
+ * The bounds are moved past the rows scanned, leaving the rest to a kernel.
+ */
+#define TABLE_FIND_SIMD_SCAN(EQ)                                                                                \
+do                                                                                                              \
+{                                                                                                               \
+  const char *base = view->base;                                                                                \
+                                                                                                                \
+  if (order == TABLE_ASCENDING)                                                                                 \
+  {                                                                                                             \
+    int row_index = *minimum_index;                                                                             \
+    for (; row_index <= *maximum_index - lanes + 1; row_index += lanes)                                         \
+    {                                                                                                           \
+      uint32_t mask = TABLE_SIMD_MASK(EQ(TABLE_SIMD_LOAD(base + (size_t)row_index * size), needle));            \
+      while (mask)                                                                                              \
+      {                                                                                                         \
+        int lane = __builtin_ctz(mask) / (int)size;                                                             \
+        if (!view->null_count || TABLE_BITMAP_GET(view->validity, row_index + lane))                            \
+          return row_index + lane;                                                                              \
+        mask &= ~(lane_bits << (lane * size));                                                                  \
+      }                                                                                                         \
+    }                                                                                                           \
+    *minimum_index = row_index;                                                                                 \
+  }                                                                                                             \
+  else                                                                                                          \
+  {                                                                                                             \
+    int row_index = *maximum_index - lanes + 1;                                                                 \
+    for (; row_index >= *minimum_index; row_index -= lanes)                                                     \
+    {                                                                                                           \
+      uint32_t mask = TABLE_SIMD_MASK(EQ(TABLE_SIMD_LOAD(base + (size_t)row_index * size), needle));            \
+      while (mask)                                                                                              \
+      {                                                                                                         \
+        int lane = (31 - __builtin_clz(mask)) / (int)size;                                                      \
+        if (!view->null_count || TABLE_BITMAP_GET(view->validity, row_index + lane))                            \
+          return row_index + lane;                                                                              \
+        mask &= ~(lane_bits << (lane * size));                                                                  \
+      }                                                                                                         \
+    }                                                                                                           \
+    *maximum_index = row_index + lanes - 1;                                                                     \
+  }                                                                                                             \
+                                                                                                                \
+  return TABLE_INDEX_NOT_FOUND;                                                                                 \
+} while (0)
+
+/*
+ * Scan whole vectors of the rows from minimum_index to maximum_index of a
+ * dense view in ascending order, adding every matching row that has a value
+ * to the selection out, if any, until count reaches limit. minimum_index is
+ * moved past the rows scanned. Returns the count.
+ */
+#define TABLE_FIND_ALL_SIMD_SCAN(EQ)                                                                            \
+do                                                                                                              \
+{                                                                                                               \
+  const char *base = view->base;                                                                                \
+  int row_index = *minimum_index;                                                                               \
+                                                                                                                \
+  for (; row_index <= maximum_index - lanes + 1; row_index += lanes)                                            \
+  {                                                                                                             \
+    uint32_t mask = TABLE_SIMD_MASK(EQ(TABLE_SIMD_LOAD(base + (size_t)row_index * size), needle));              \
+    while (mask)                                                                                                \
+    {                                                                                                           \
+      int lane = __builtin_ctz(mask) / (int)size;                                                               \
+      mask &= ~(lane_bits << (lane * size));                                                                    \
+      if (view->null_count && !TABLE_BITMAP_GET(view->validity, row_index + lane))                              \
+        continue;                                                                                               \
+      if (out && table_selection_add(out, row_index + lane))                                                    \
+        return -1;                                                                                              \
+      if (++count == limit)                                                                                     \
+        return count;                                                                                           \
+    }                                                                                                           \
+  }                                                                                                             \
+                                                                                                                \
+  *minimum_index = row_index;                                                                                   \
+  return count;                                                                                                 \
+} while (0)
+
+/* Run a vector scan with the equality compare for the type and size of the view */
+#define TABLE_FIND_SIMD_DISPATCH(SCAN)                                                                          \
+do                                                                                                              \
+{                                                                                                               \
+  if (view->type == TABLE_FLOAT)                                                                                \
+    SCAN(TABLE_SIMD_EQ_FLOAT);                                                                                  \
+  if (view->type == TABLE_DOUBLE)                                                                               \
+    SCAN(TABLE_SIMD_EQ_DOUBLE);                                                                                 \
+                                                                                                                \
+  switch (size)                                                                                                 \
+  {                                                                                                             \
+    case 1:                                                                                                     \
+      SCAN(TABLE_SIMD_EQ_8);                                                                                    \
+    case 2:                                                                                                     \
+      SCAN(TABLE_SIMD_EQ_16);                                                                                   \
+    case 4:                                                                                                     \
+      SCAN(TABLE_SIMD_EQ_32);                                                                                   \
+    default:                                                                                                    \
+      SCAN(TABLE_SIMD_EQ_64);                                                                                   \
+  }                                                                                                             \
+} while (0)
+
+/*
+ * Binary search the rows from minimum to maximum of a sorted column, where
+ * COMPARE compares the search value to the row middle in the order of the
+ * column. Returns the first row not before the value for TABLE_FIRST, or
+ * the first row after it for TABLE_LAST.
+ */
+#define TABLE_SORTED_BOUND(COMPARE)                                                                             \
+do                                                                                                              \
+{                                                                                                               \
+  int low = minimum, high = maximum + 1;                                                                        \
+                                                                                                                \
+  while (low < high)                                                                                            \
+  {                                                                                                             \
+    int middle = low + (high - low) / 2;                                                                        \
+    int result = COMPARE;                                                                                       \
+    if (result > 0 || (!result && position == TABLE_LAST))                                                      \
+      low = middle + 1;                                                                                         \
+    else                                                                                                        \
+      high = middle;                                                                                            \
+  }                                                                                                             \
+                                                                                                                \
+  return low;                                                                                                   \
+} while (0)
+
+/* The value of a row of a column known to have one */
+#define TABLE_FIND_CELL(type, row_index) (*(const type*)TABLE_KERNEL_SLOT(t, view, row_index, column_index))
+
+/*
+ * Find and binary search kernels for the default comparator of a data type,
+ * comparing values in place instead of through the comparator. Rows without
+ * a value sort before every value, as with the default comparators.
+ */
+#define TABLE_FIND_KERNEL(name, type, data_type, kind)                                                          \
+static int table_find_valid_##name(const table *t, const table_column *column, const table_column_view *view,   \
+                                   int column_index, const void *value, table_order order,                       \
+                                   int minimum_index, int maximum_index)                                         \
+{                                                                                                               \
+  type search = kind##_LOAD(type, value);                                                                       \
+  TABLE_FIND_SCAN(!kind##_COMPARE(search, TABLE_FIND_CELL(type, row_index)));                                   \
+}                                                                                                               \
+                                                                                                                \
+static int table_find_all_valid_##name(const table *t, const table_column *column, const table_column_view *view,\
+                                       int column_index, const void *value, int minimum_index, int maximum_index, \
+                                       int count, int limit, table_selection *out)                                \
+{                                                                                                               \
+  type search = kind##_LOAD(type, value);                                                                       \
+  TABLE_FIND_ALL_SCAN(!kind##_COMPARE(search, TABLE_FIND_CELL(type, row_index)));                               \
+}                                                                                                               \
+                                                                                                                \
+static int table_sorted_bound_##name(const table *t, const table_column *column, const table_column_view *view, \
+                                     int column_index, const void *value, int sign, table_position position,     \
+                                     int minimum, int maximum)                                                   \
+{                                                                                                               \
+  type search = kind##_LOAD(type, value);                                                                       \
+  TABLE_SORTED_BOUND(sign * (column->null_count && !TABLE_BITMAP_GET(column->validity, middle) ? 1 :            \
+                             kind##_COMPARE(search, TABLE_FIND_CELL(type, middle))));                            \
+}
+
+TABLE_KERNEL_TYPES(TABLE_FIND_KERNEL)
+
 /**
  * \brief Find a value in the table
  * \param[in] t The table
@@ -19,8 +347,17 @@
  */
 int table_subset_find(const table *t, int column_index, void* value, table_order order, int minimum_index, int maximum_index)
 {
-  table_comparator compare = table_get_column_comparator(t, column_index);
-  
+  table_column *column = table_get_col_ptr(t, column_index);
+  table_comparator compare = column->comparator;
+
+  /* Default comparators never match a value against a row without one */
+  if (value && compare == table_get_default_comparator_for_data_type(column->type))
+  {
+    if (column->hash_index)
+      return table_hash_index_find(column->hash_index, value, order, minimum_index, maximum_index);
+    return table_subset_find_valid(t, column_index, value, order, minimum_index, maximum_index);
+  }
+
   if (order == TABLE_ASCENDING)
   {
     for (int row_index = minimum_index; row_index <= maximum_index; row_index++)
@@ -37,6 +374,283 @@ int table_subset_find(const table *t, int column_index, void* value, table_order
   return TABLE_INDEX_NOT_FOUND;
 }
 
+/**
+ * \brief Find every row holding a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[out] out The selection to fill with the rows found
+ * \return The number of rows found, or -1 on allocation failure
+ */
+int table_find_all(const table *t, int column_index, void *value, table_selection *out)
+{
+  return table_subset_find_all(t, column_index, value, 0, table_get_row_length(t) - 1, INT_MAX, out);
+}
+
+/**
+ * \brief Find the first rows holding a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[in] limit The most rows to find
+ * \param[out] out The selection to fill with the rows found
+ * \return The number of rows found, or -1 on allocation failure
+ */
+int table_find_all_limit(const table *t, int column_index, void *value, int limit, table_selection *out)
+{
+  return table_subset_find_all(t, column_index, value, 0, table_get_row_length(t) - 1, limit, out);
+}
+
+/**
+ * \brief Count the rows holding a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \return The number of rows holding the value
+ */
+int table_count(const table *t, int column_index, void *value)
+{
+  return table_subset_find_all(t, column_index, value, 0, table_get_row_length(t) - 1, INT_MAX, NULL);
+}
+
+/**
+ * \brief Find the first rows of a subset of the table holding a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[in] minimum_index The lowest index to consider while searching
+ * \param[in] maximum_index The highest index to consider while searching
+ * \param[in] limit The most rows to find
+ * \param[out] out The selection to fill with the rows found in ascending order, or NULL to only count them
+ * \return The number of rows found, or -1 on allocation failure
+ *
+ * The rows are found in a single pass, matching as table_subset_find() does.
+ */
+int table_subset_find_all(const table *t, int column_index, void *value, int minimum_index, int maximum_index,
+                          int limit, table_selection *out)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  table_comparator compare = column->comparator;
+  int count = 0;
+
+  if (out)
+    table_selection_reset(out, t);
+
+  if (limit <= 0 || minimum_index > maximum_index)
+    return 0;
+
+  if (value && compare == table_get_default_comparator_for_data_type(column->type))
+  {
+    if (column->hash_index)
+      return table_hash_index_find_all(column->hash_index, value, minimum_index, maximum_index, limit, out);
+    return table_subset_find_all_valid(t, column_index, value, minimum_index, maximum_index, limit, out);
+  }
+
+  for (int row_index = minimum_index; row_index <= maximum_index; row_index++)
+  {
+    if (!compare(value, table_get(t, row_index, column_index)))
+    {
+      if (out && table_selection_add(out, row_index))
+        return -1;
+      if (++count == limit)
+        break;
+    }
+  }
+
+  return count;
+}
+
+/**
+ * \brief Find a value among the rows of a column that have a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[in] order The order in which to linear search the table
+ * \param[in] minimum_index The lowest index to consider while searching
+ * \param[in] maximum_index The highest index to consider while searching
+ * \return The row of the first occurrence of the search value or TABLE_INDEX_NOT_FOUND
+ *
+ * The kernel for the column data type is picked once, column storage values
+ * are read straight from a view of the column. Where vectors are available
+ * dense numeric columns are compared a vector of rows at a time first.
+ */
+static int table_subset_find_valid(const table *t, int column_index, void *value, table_order order, int minimum_index, int maximum_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  table_comparator compare = column->comparator;
+  table_column_view view;
+
+  if (minimum_index > maximum_index)
+    return TABLE_INDEX_NOT_FOUND;
+
+  table_storage_get_view(t, column_index, &view);
+
+#ifdef TABLE_FIND_SIMD
+  if (table_find_simd_supported(&view))
+  {
+    int row_index = table_find_simd(&view, value, order, &minimum_index, &maximum_index);
+    if (row_index != TABLE_INDEX_NOT_FOUND)
+      return row_index;
+  }
+#endif
+
+  switch (column->type)
+  {
+#define TABLE_FIND_DISPATCH(name, type, data_type, kind) \
+    case data_type: \
+      return table_find_valid_##name(t, column, &view, column_index, value, order, minimum_index, maximum_index);
+    TABLE_KERNEL_TYPES(TABLE_FIND_DISPATCH)
+#undef TABLE_FIND_DISPATCH
+    default:
+      break;
+  }
+
+  TABLE_FIND_SCAN(!compare(value, table_find_get_value(t, &view, row_index, column_index)));
+}
+
+/**
+ * \brief Find every occurrence of a value among the rows of a column that have a value
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[in] minimum_index The lowest index to consider while searching
+ * \param[in] maximum_index The highest index to consider while searching
+ * \param[in] limit The most rows to find
+ * \param[out] out The selection to add the rows found to, or NULL to only count them
+ * \return The number of rows found, or -1 on allocation failure
+ */
+static int table_subset_find_all_valid(const table *t, int column_index, void *value, int minimum_index, int maximum_index,
+                                       int limit, table_selection *out)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  table_comparator compare = column->comparator;
+  table_column_view view;
+  int count = 0;
+
+  table_storage_get_view(t, column_index, &view);
+
+#ifdef TABLE_FIND_SIMD
+  if (table_find_simd_supported(&view))
+  {
+    count = table_find_all_simd(&view, value, &minimum_index, maximum_index, count, limit, out);
+    if (count < 0 || count == limit)
+      return count;
+  }
+#endif
+
+  switch (column->type)
+  {
+#define TABLE_FIND_ALL_DISPATCH(name, type, data_type, kind) \
+    case data_type: \
+      return table_find_all_valid_##name(t, column, &view, column_index, value, minimum_index, maximum_index, count, limit, out);
+    TABLE_KERNEL_TYPES(TABLE_FIND_ALL_DISPATCH)
+#undef TABLE_FIND_ALL_DISPATCH
+    default:
+      break;
+  }
+
+  TABLE_FIND_ALL_SCAN(!compare(value, table_find_get_value(t, &view, row_index, column_index)));
+}
+
+#ifdef TABLE_FIND_SIMD
+/**
+ * \brief Check whether a column view can be scanned with vector compares
+ * \param[in] view The column view
+ * \return true for column storage of a fixed size type with a bitwise or floating point equality
+ */
+static bool table_find_simd_supported(const table_column_view *view)
+{
+  switch (view->type)
+  {
+    case TABLE_STRING:
+    case TABLE_PTR:
+    case TABLE_LDOUBLE:
+      return false;
+    default:
+      break;
+  }
+
+  return view->base && view->stride == table_get_data_type_size(view->type) &&
+         (view->stride == 1 || view->stride == 2 || view->stride == 4 || view->stride == 8);
+}
+
+/**
+ * \brief Find a value in column storage a vector of rows at a time
+ * \param[in] view The column view, with values packed one after another
+ * \param[in] value The value to search for
+ * \param[in] order The order in which to linear search the rows
+ * \param[in,out] minimum_index The lowest row to consider, moved past the rows scanned in ascending order
+ * \param[in,out] maximum_index The highest row to consider, moved past the rows scanned in descending order
+ * \return The row of the first occurrence of the search value or TABLE_INDEX_NOT_FOUND
+ *
+ * Only whole vectors are compared. When nothing is found the bounds are left
+ * around the rows at the far end that did not fill a vector.
+ */
+static int table_find_simd(const table_column_view *view, const void *value, table_order order, int *minimum_index, int *maximum_index)
+{
+  size_t size = view->stride;
+  int lanes = (int)(TABLE_SIMD_BYTES / size);
+  uint32_t lane_bits = ((uint32_t)1 << size) - 1;
+  table_simd needle = table_find_simd_needle(value, size);
+
+  TABLE_FIND_SIMD_DISPATCH(TABLE_FIND_SIMD_SCAN);
+}
+
+/**
+ * \brief Find every occurrence of a value in column storage a vector of rows at a time
+ * \param[in] view The column view, with values packed one after another
+ * \param[in] value The value to search for
+ * \param[in,out] minimum_index The lowest row to consider, moved past the rows scanned
+ * \param[in] maximum_index The highest row to consider
+ * \param[in] count The number of rows found so far
+ * \param[in] limit The number of rows to stop at
+ * \param[out] out The selection to add the rows found to, or NULL to only count them
+ * \return The number of rows found, or -1 on allocation failure
+ */
+static int table_find_all_simd(const table_column_view *view, const void *value, int *minimum_index, int maximum_index,
+                               int count, int limit, table_selection *out)
+{
+  size_t size = view->stride;
+  int lanes = (int)(TABLE_SIMD_BYTES / size);
+  uint32_t lane_bits = ((uint32_t)1 << size) - 1;
+  table_simd needle = table_find_simd_needle(value, size);
+
+  TABLE_FIND_SIMD_DISPATCH(TABLE_FIND_ALL_SIMD_SCAN);
+}
+
+/**
+ * \brief Fill a vector with copies of a value
+ * \param[in] value The value
+ * \param[in] size The size of the value
+ * \return The vector
+ */
+static table_simd table_find_simd_needle(const void *value, size_t size)
+{
+  unsigned char bytes[TABLE_SIMD_BYTES];
+
+  for (size_t offset = 0; offset < TABLE_SIMD_BYTES; offset += size)
+    memcpy(bytes + offset, value, size);
+
+  return TABLE_SIMD_LOAD(bytes);
+}
+#endif
+
+/**
+ * \brief Get a value that is known to be present
+ * \param[in] t The table
+ * \param[in] view The column view
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \return The value pointer
+ */
+static inline void *table_find_get_value(const table *t, const table_column_view *view, int row_index, int column_index)
+{
+  if (!view->base)
+    return table_storage_get_value(t, row_index, column_index);
+
+  return TABLE_VIEW_VALUE(view, row_index);
+}
+
 /**
  * \brief Find a value in the table
  * \param[in] t The table
@@ -346,7 +960,7 @@ int table_find_uchar(const table *t, int column_index, unsigned char value, tabl
  */
 int table_find_string(const table *t, int column_index, const char *value, table_order order)
 {
-  return table_find(t, column_index, (void*)&value, order);
+  return table_find(t, column_index, (void*)value, order);
 }
 
 /**
@@ -383,41 +997,236 @@ int table_sorted_find(const table *t, int col, void *value, table_position posit
  * \param[in] position The location of the returned row if there are more than one result
  * \param[in] minimum The lowest row to consider
  * \param[in] maximum The highest row to consider
- * \return The row matching given criteria
+ * \return The row matching given criteria, or the negated row the value would be inserted at
+ *
+ * The rows must be sorted by the column comparator, in the order the table
+ * was last sorted in when the column was the first column sorted by, and in
+ * ascending order otherwise. The table is never re-sorted here, see
+ * table_sorted_lookup() for that.
  */
 int table_sorted_subset_find(const table *t, int col, void *value, table_position position, int minimum, int maximum)
 {
   table_comparator func = table_get_column_comparator(t, col);
-  int middle = (maximum - minimum) / 2 + minimum;
-  int compare = func(value, table_get(t, middle, col));
+  int bound, row;
+
+  bound = table_sorted_bound(t, col, value, table_sorted_order(t, col), position, minimum, maximum);
+  row = position == TABLE_FIRST ? bound : bound - 1;
+
+  if (row >= minimum && row <= maximum && !func(value, table_get(t, row, col)))
+    return row;
+
+  return -bound;
+}
+
+/**
+ * \brief Binary search a table that may be re-sorted first
+ * \param[in,out] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to match on
+ * \param[in] position The location of the returned row if there are more than one result
+ * \return The row matching given criteria, or the negated row the value would be inserted at
+ *
+ * With table_set_sort_on_find() set, rows that are out of the order they
+ * were last sorted in are re-sorted before the search, notifying
+ * TABLE_SORTED. Otherwise this is table_sorted_find().
+ */
+int table_sorted_lookup(table *t, int col, void *value, table_position position)
+{
+  if (t->sort_on_find)
+    table_resort(t);
+
+  return table_sorted_find(t, col, value, position);
+}
+
+/**
+ * \brief Find the rows holding a value in a table that may be re-sorted first
+ * \param[in,out] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \param[out] first The first row holding the value, or where it would be inserted
+ * \param[out] last The row after the last row holding the value
+ * \return The number of rows holding the value
+ *
+ * The table is re-sorted first as with table_sorted_lookup(). Otherwise
+ * this is table_sorted_equal_range().
+ */
+int table_sorted_lookup_equal_range(table *t, int col, void *value, int *first, int *last)
+{
+  if (t->sort_on_find)
+    table_resort(t);
+
+  return table_sorted_equal_range(t, col, value, first, last);
+}
+
+/**
+ * \brief Find the first row not before a value in a sorted column
+ * \param[in] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \return The first row holding the value or after it, the row length if there is none
+ *
+ * The column is searched in the order the table was last sorted in when it
+ * was the first column sorted by, otherwise it must be in ascending order.
+ */
+int table_sorted_lower_bound(const table *t, int col, void *value)
+{
+  return table_sorted_bound(t, col, value, table_sorted_order(t, col), TABLE_FIRST, 0, table_get_row_length(t) - 1);
+}
 
-  if (minimum > maximum)
-    return -middle;
+/**
+ * \brief Find the first row after a value in a sorted column
+ * \param[in] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \return The first row after the value, the row length if there is none
+ *
+ * The column is searched in the same order as with table_sorted_lower_bound().
+ */
+int table_sorted_upper_bound(const table *t, int col, void *value)
+{
+  return table_sorted_bound(t, col, value, table_sorted_order(t, col), TABLE_LAST, 0, table_get_row_length(t) - 1);
+}
 
-  switch (compare)
+/**
+ * \brief Find the rows holding a value in a sorted column
+ * \param[in] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \param[out] first The first row holding the value, or where it would be inserted
+ * \param[out] last The row after the last row holding the value
+ * \return The number of rows holding the value
+ *
+ * The column is searched in the same order as with table_sorted_lower_bound().
+ */
+int table_sorted_equal_range(const table *t, int col, void *value, int *first, int *last)
+{
+  return table_sorted_subset_equal_range(t, col, value, table_sorted_order(t, col), 0, table_get_row_length(t) - 1,
+                                         first, last);
+}
+
+/**
+ * \brief Count the rows holding a value in a sorted column
+ * \param[in] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \return The number of rows holding the value
+ *
+ * The column is searched in the same order as with table_sorted_lower_bound().
+ */
+int table_sorted_count(const table *t, int col, void *value)
+{
+  int first, last;
+  return table_sorted_equal_range(t, col, value, &first, &last);
+}
+
+/**
+ * \brief Find the rows holding a value in a subset of a sorted column
+ * \param[in] t The table
+ * \param[in] col The column to search
+ * \param[in] value The value to search for
+ * \param[in] order The order the rows are sorted in by the column
+ * \param[in] minimum The lowest row to consider
+ * \param[in] maximum The highest row to consider
+ * \param[out] first The first row holding the value, or where it would be inserted
+ * \param[out] last The row after the last row holding the value
+ * \return The number of rows holding the value
+ *
+ * Both ends of the range are binary searched, so runs of equal values cost
+ * no more than a single search each.
+ */
+int table_sorted_subset_equal_range(const table *t, int col, void *value, table_order order, int minimum, int maximum,
+                                    int *first, int *last)
+{
+  *first = table_sorted_bound(t, col, value, order, TABLE_FIRST, minimum, maximum);
+  *last = table_sorted_bound(t, col, value, order, TABLE_LAST, *first, maximum);
+  return *last - *first;
+}
+
+/**
+ * \brief Get the order a column was last sorted in
+ * \param[in] t The table
+ * \param[in] column_index The column
+ * \return The order of the first sort column if it is the column, otherwise TABLE_ASCENDING
+ */
+static table_order table_sorted_order(const table *t, int column_index)
+{
+  const table_sort_spec *spec = table_get_sort_spec(t);
+
+  return spec->length && spec->cols[0] == column_index ? spec->orders[0] : TABLE_ASCENDING;
+}
+
+/**
+ * \brief Binary search a subset of a sorted column
+ * \param[in] t The table
+ * \param[in] column_index The column to search
+ * \param[in] value The value to search for
+ * \param[in] order The order the rows are sorted in by the column
+ * \param[in] position TABLE_FIRST for the first row not before the value, TABLE_LAST for the first row after it
+ * \param[in] minimum The lowest row to consider
+ * \param[in] maximum The highest row to consider
+ * \return The row found, maximum + 1 if there is none
+ *
+ * Descending columns are searched by negating each comparison, as the sort
+ * reverses the comparator for them, rows without a value included.
+ */
+static int table_sorted_bound(const table *t, int column_index, void *value, table_order order, table_position position,
+                              int minimum, int maximum)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  table_comparator compare = column->comparator;
+  int sign = order == TABLE_DESCENDING ? -1 : 1;
+  table_column_view view;
+
+  if (value && compare == table_get_default_comparator_for_data_type(column->type))
   {
-    case 0:
-      do
-      {
-        if (position == TABLE_FIRST)
-          compare = func(table_get(t, --middle, col), value);
-        else
-          compare = func(table_get(t, ++middle, col), value);
-      } while (!compare);
-      if (position == TABLE_FIRST)
-        return ++middle;
-      else
-        return --middle;
-      break;
-    case 1:
-      return table_sorted_subset_find(t, col, value, position, middle, maximum);
-      break;
-    case -1:
-      return table_sorted_subset_find(t, col, value, position, minimum, middle - 1);
-      break;
+    if (column->type == TABLE_STRING && table_get_row_length(t) >= PREFIX_SEARCH_CUTOFF)
+    {
+      const uint64_t *prefixes = table_storage_get_prefixes(t, column_index, true);
+      if (prefixes)
+        return table_sorted_bound_prefix(t, column, prefixes, column_index, value, sign, position, minimum, maximum);
+    }
+
+    table_storage_get_view(t, column_index, &view);
+
+    switch (column->type)
+    {
+#define TABLE_SORTED_DISPATCH(name, type, data_type, kind) \
+      case data_type: \
+        return table_sorted_bound_##name(t, column, &view, column_index, value, sign, position, minimum, maximum);
+      TABLE_KERNEL_TYPES(TABLE_SORTED_DISPATCH)
+#undef TABLE_SORTED_DISPATCH
+      default:
+        break;
+    }
   }
-  
-  return -middle;
+
+  TABLE_SORTED_BOUND(sign * compare(value, table_get(t, middle, column_index)));
+}
+
+/**
+ * \brief Binary search a subset of a sorted string column by the cached prefixes of its strings
+ * \param[in] t The table
+ * \param[in] column The column to search
+ * \param[in] prefixes The cached prefix of every row of the column
+ * \param[in] column_index The column to search
+ * \param[in] value The string to search for
+ * \param[in] sign 1 for a column sorted in ascending order, -1 for descending
+ * \param[in] position TABLE_FIRST for the first row not before the value, TABLE_LAST for the first row after it
+ * \param[in] minimum The lowest row to consider
+ * \param[in] maximum The highest row to consider
+ * \return The row found, maximum + 1 if there is none
+ *
+ * Strings are only read when their prefix ties with the prefix of the value.
+ */
+static int table_sorted_bound_prefix(const table *t, const table_column *column, const uint64_t *prefixes, int column_index,
+                                     const char *value, int sign, table_position position, int minimum, int maximum)
+{
+  uint64_t search = table_string_prefix(value);
+
+  TABLE_SORTED_BOUND(sign * (column->null_count && !TABLE_BITMAP_GET(column->validity, middle) ? 1 :
+                             prefixes[middle] != search ? (search > prefixes[middle]) - (search < prefixes[middle]) :
+                             !(search & 0xFF) ? 0 :
+                             strcmp(value + 8, (const char*)table_storage_get_value(t, middle, column_index) + 8)));
 }
 
 /**
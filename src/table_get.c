@@ -15,7 +15,7 @@
  */
 void *table_get(const table *t, int row, int col)
 {
-  return table_get_cell_ptr(t, row, col)->value;
+  return table_storage_get(t, row, col);
 }
 
 /**
@@ -0,0 +1,529 @@
+/**
+ * \file
+ * \brief The table hash index implementation file
+ *
+ * This file handles hash indexes. A hash index maps the values of a column
+ * to the rows holding them, so that finding a value takes expected constant
+ * time instead of a scan. The index follows the table through a registered
+ * callback: changed cells are moved within the index, added and removed rows
+ * are added and removed, and bulk changes or sorts rebuild it.
+ */
+#include "table_defs.h"
+
+static const int HASH_INDEX_MIN_CAPACITY = 16;
+
+static bool table_hash_index_supported(const table *t, int col);
+static uint64_t table_hash_index_hash(table_data_type type, const void *value);
+static void table_hash_index_callback(table *t, int row, int column, table_event_type event_type, void *data);
+static int table_hash_index_rebuild(table_hash_index *index);
+static int table_hash_index_reserve_rows(table_hash_index *index, int rows);
+static int table_hash_index_resize(table_hash_index *index, int capacity);
+static int table_hash_index_insert(table_hash_index *index, int row);
+static void table_hash_index_place(table_hash_index *index, int row);
+static void table_hash_index_remove(table_hash_index *index, int row);
+static void table_hash_index_shift(table_hash_index *index, int row);
+static int table_hash_index_compare_rows(const void *row1, const void *row2);
+
+/**
+ * \brief Create a hash index on a column
+ * \param[out] t The table
+ * \param[in] col The column to index
+ * \return 0 on success, or -1 if the column cannot be hashed or memory runs out
+ *
+ * Finds on the column then look the value up in the index for as long as
+ * the column uses its default comparator. Only integer, character, boolean,
+ * string and pointer columns can be hashed, as the default comparator of
+ * floating point columns considers NaN equal to every value. Creating an
+ * index on a column that already has one rebuilds it.
+ */
+int table_create_hash_index(table *t, int col)
+{
+  table_column *column = table_get_col_ptr(t, col);
+  table_hash_index *index = column->hash_index;
+
+  if (!table_hash_index_supported(t, col))
+    return -1;
+
+  if (!index)
+  {
+    index = calloc(1, sizeof(table_hash_index));
+    if (!index)
+      return -1;
+
+    index->t = t;
+    index->col = col;
+    column->hash_index = index;
+    table_register_callback(t, table_hash_index_callback, index,
+                            TABLE_DATA_MODIFIED | TABLE_ROW_ADDED | TABLE_ROW_REMOVED |
+                            TABLE_COLUMN_REMOVED | TABLE_SORTED);
+  }
+
+  if (table_hash_index_rebuild(index))
+  {
+    table_hash_index_destroy(t, col);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * \brief Drop the hash index of a column
+ * \param[out] t The table
+ * \param[in] col The column
+ */
+void table_drop_hash_index(table *t, int col)
+{
+  table_hash_index_destroy(t, col);
+}
+
+/**
+ * \brief Determine if a column has a hash index
+ * \param[in] t The table
+ * \param[in] col The column
+ * \return TRUE or FALSE
+ */
+bool table_has_hash_index(const table *t, int col)
+{
+  return table_get_col_ptr(t, col)->hash_index != NULL;
+}
+
+/**
+ * \brief Destroy the hash index of a column, if it has one
+ * \param[out] t The table
+ * \param[in] col The column
+ */
+void table_hash_index_destroy(table *t, int col)
+{
+  table_column *column = table_get_col_ptr(t, col);
+  table_hash_index *index = column->hash_index;
+
+  if (!index)
+    return;
+
+  table_unregister_callback(t, table_hash_index_callback, index);
+  free(index->slots);
+  free(index->hashes);
+  free(index->positions);
+  free(index);
+  column->hash_index = NULL;
+}
+
+/**
+ * \brief Find a value in a hash index
+ * \param[in] index The hash index
+ * \param[in] value The value to search for
+ * \param[in] order TABLE_ASCENDING for the first matching row, TABLE_DESCENDING for the last
+ * \param[in] minimum_index The lowest row to consider
+ * \param[in] maximum_index The highest row to consider
+ * \return The row found, or TABLE_INDEX_NOT_FOUND
+ *
+ * Every row holding the value is visited, so a value held by many rows costs
+ * as many comparisons.
+ */
+int table_hash_index_find(const table_hash_index *index, const void *value, table_order order, int minimum_index, int maximum_index)
+{
+  const table *t = index->t;
+  table_column *column = table_get_col_ptr(t, index->col);
+  uint64_t hash = table_hash_index_hash(column->type, value);
+  int mask = index->capacity - 1;
+  int found = TABLE_INDEX_NOT_FOUND;
+
+  if (!index->length)
+    return TABLE_INDEX_NOT_FOUND;
+
+  for (int slot = hash & mask; index->slots[slot] != -1; slot = (slot + 1) & mask)
+  {
+    int row = index->slots[slot];
+    const void *row_value;
+
+    if (index->hashes[row] != hash || row < minimum_index || row > maximum_index)
+      continue;
+
+    if (found != TABLE_INDEX_NOT_FOUND && (order == TABLE_ASCENDING ? row > found : row < found))
+      continue;
+
+    row_value = table_storage_get(t, row, index->col);
+    if (row_value && !column->comparator(value, row_value))
+      found = row;
+  }
+
+  return found;
+}
+
+/**
+ * \brief Find every row holding a value in a hash index
+ * \param[in] index The hash index
+ * \param[in] value The value to search for
+ * \param[in] minimum_index The lowest row to consider
+ * \param[in] maximum_index The highest row to consider
+ * \param[in] limit The most rows to find, the lowest rows are kept
+ * \param[out] out The emptied selection to fill with the rows found, or NULL to only count them
+ * \return The number of rows found, or -1 on allocation failure
+ *
+ * Rows come out of the index in no particular order, so the selection is
+ * sorted before it is cut down to the limit.
+ */
+int table_hash_index_find_all(const table_hash_index *index, const void *value, int minimum_index, int maximum_index,
+                              int limit, table_selection *out)
+{
+  const table *t = index->t;
+  table_column *column = table_get_col_ptr(t, index->col);
+  uint64_t hash = table_hash_index_hash(column->type, value);
+  int mask = index->capacity - 1;
+  int count = 0;
+
+  if (!index->length)
+    return 0;
+
+  for (int slot = hash & mask; index->slots[slot] != -1; slot = (slot + 1) & mask)
+  {
+    int row = index->slots[slot];
+    const void *row_value;
+
+    if (index->hashes[row] != hash || row < minimum_index || row > maximum_index)
+      continue;
+
+    row_value = table_storage_get(t, row, index->col);
+    if (!row_value || column->comparator(value, row_value))
+      continue;
+
+    if (out && table_selection_add(out, row))
+      return -1;
+    count++;
+  }
+
+  if (out)
+    qsort(out->rows, count, sizeof(int), table_hash_index_compare_rows);
+
+  if (count > limit)
+    count = limit;
+  if (out)
+    out->length = count;
+
+  return count;
+}
+
+/**
+ * \brief Compare two rows for qsort()
+ * \param[in] row1 The first row
+ * \param[in] row2 The second row
+ * \return The comparison of the rows
+ */
+static int table_hash_index_compare_rows(const void *row1, const void *row2)
+{
+  int a = *(const int*)row1, b = *(const int*)row2;
+  return (a > b) - (a < b);
+}
+
+/**
+ * \brief Determine if a column can be hashed
+ * \param[in] t The table
+ * \param[in] col The column
+ * \return TRUE or FALSE
+ */
+static bool table_hash_index_supported(const table *t, int col)
+{
+  table_column *column = table_get_col_ptr(t, col);
+
+  if (column->comparator != table_get_default_comparator_for_data_type(column->type))
+    return false;
+
+  switch (column->type)
+  {
+    case TABLE_FLOAT:
+    case TABLE_DOUBLE:
+    case TABLE_LDOUBLE:
+      return false;
+    default:
+      return true;
+  }
+}
+
+/**
+ * \brief Hash a value
+ * \param[in] type The data type of the value
+ * \param[in] value The value, a string or pointer itself for those types
+ * \return The hash of the value
+ *
+ * Strings are hashed with FNV-1a, other values by their bytes, and the
+ * result is mixed so that sequential keys spread across the slots.
+ */
+static uint64_t table_hash_index_hash(table_data_type type, const void *value)
+{
+  uint64_t hash = 0;
+
+  if (type == TABLE_STRING)
+  {
+    hash = 0xcbf29ce484222325u;
+    for (const unsigned char *c = value; *c; c++)
+      hash = (hash ^ *c) * 0x100000001b3u;
+  }
+  else if (type == TABLE_PTR)
+    hash = (uintptr_t)value;
+  else
+    memcpy(&hash, value, table_get_data_type_size(type));
+
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdu;
+  hash ^= hash >> 33;
+  hash *= 0xc4ceb9fe1a85ec53u;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+/**
+ * \brief Keep a hash index current with a change to its table
+ * \param[in] t The table
+ * \param[in] row The row changed, or -1 for many rows
+ * \param[in] column The column changed, or -1 for many columns
+ * \param[in] event_type The change
+ * \param[in] data The hash index
+ *
+ * An index that runs out of memory is dropped, so that finds on its column
+ * scan the rows again.
+ */
+static void table_hash_index_callback(table *t, int row, int column, table_event_type event_type, void *data)
+{
+  table_hash_index *index = data;
+  int rows, rc = 0;
+
+  if (t != index->t)
+    return;
+
+  switch (event_type)
+  {
+    case TABLE_DATA_MODIFIED:
+      if (row < 0)
+        rc = table_hash_index_rebuild(index);
+      else if (column == index->col)
+      {
+        table_hash_index_remove(index, row);
+        rc = table_hash_index_insert(index, row);
+      }
+      break;
+    case TABLE_ROW_ADDED:
+      /* New rows have no value yet, table_add_row() notifies before counting its row */
+      rows = row + 1 > table_get_row_length(t) ? row + 1 : table_get_row_length(t);
+      rc = table_hash_index_reserve_rows(index, rows);
+      if (rc)
+        break;
+      for (int i = index->rows_length; i < rows; i++)
+        index->positions[i] = -1;
+      index->rows_length = rows;
+      break;
+    case TABLE_ROW_REMOVED:
+      if (row < 0)
+        rc = table_hash_index_rebuild(index);
+      else if (row < table_get_row_length(t) && table_row_is_removed(t, row))
+        table_hash_index_remove(index, row);
+      else
+        table_hash_index_shift(index, row);
+      break;
+    case TABLE_COLUMN_REMOVED:
+      if (column < index->col)
+        index->col--;
+      break;
+    case TABLE_SORTED:
+      rc = table_hash_index_rebuild(index);
+      break;
+    default:
+      break;
+  }
+
+  if (rc)
+    table_hash_index_destroy(t, index->col);
+}
+
+/**
+ * \brief Index every row of the column again
+ * \param[out] index The hash index
+ * \return 0 on success, or -1 on allocation failure
+ */
+static int table_hash_index_rebuild(table_hash_index *index)
+{
+  const table *t = index->t;
+  int row_length = table_get_row_length(t);
+  int values = row_length - table_get_col_ptr(t, index->col)->null_count;
+  int capacity = HASH_INDEX_MIN_CAPACITY;
+
+  while (capacity < 2 * values)
+    capacity *= 2;
+
+  if (table_hash_index_reserve_rows(index, row_length))
+    return -1;
+
+  index->rows_length = row_length;
+  index->length = 0;
+  index->capacity = 0;
+  if (table_hash_index_resize(index, capacity))
+    return -1;
+
+  for (int row = 0; row < row_length; row++)
+  {
+    index->positions[row] = -1;
+    if (table_hash_index_insert(index, row))
+      return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * \brief Make room for the hash and slot of a number of rows
+ * \param[out] index The hash index
+ * \param[in] rows The number of rows
+ * \return 0 on success, or -1 on allocation failure, leaving the rows as they were
+ */
+static int table_hash_index_reserve_rows(table_hash_index *index, int rows)
+{
+  int allocated = index->rows_allocated ? index->rows_allocated : HASH_INDEX_MIN_CAPACITY;
+  uint64_t *hashes;
+  int *positions;
+
+  if (rows <= index->rows_allocated)
+    return 0;
+
+  while (allocated < rows)
+    allocated *= 2;
+
+  hashes = realloc(index->hashes, (size_t)allocated * sizeof(uint64_t));
+  if (!hashes)
+    return -1;
+  index->hashes = hashes;
+
+  positions = realloc(index->positions, (size_t)allocated * sizeof(int));
+  if (!positions)
+    return -1;
+  index->positions = positions;
+
+  index->rows_allocated = allocated;
+  return 0;
+}
+
+/**
+ * \brief Change the number of slots of a hash index, placing its rows again
+ * \param[out] index The hash index
+ * \param[in] capacity The number of slots, a power of two
+ * \return 0 on success, or -1 on allocation failure, leaving the slots as they were
+ */
+static int table_hash_index_resize(table_hash_index *index, int capacity)
+{
+  int *slots = index->slots;
+  int previous = index->capacity;
+
+  index->slots = malloc((size_t)capacity * sizeof(int));
+  if (!index->slots)
+  {
+    index->slots = slots;
+    return -1;
+  }
+
+  index->capacity = capacity;
+  for (int slot = 0; slot < capacity; slot++)
+    index->slots[slot] = -1;
+
+  for (int slot = 0; slot < previous; slot++)
+    if (slots[slot] != -1)
+      table_hash_index_place(index, slots[slot]);
+
+  free(slots);
+  return 0;
+}
+
+/**
+ * \brief Add a row to a hash index, if it has a value
+ * \param[out] index The hash index
+ * \param[in] row The table row
+ * \return 0 on success, or -1 on allocation failure
+ */
+static int table_hash_index_insert(table_hash_index *index, int row)
+{
+  table_data_type type = table_get_column_data_type(index->t, index->col);
+  const void *value = table_storage_get(index->t, row, index->col);
+
+  index->positions[row] = -1;
+  if (!value)
+    return 0;
+
+  if (2 * (index->length + 1) > index->capacity && table_hash_index_resize(index, index->capacity * 2))
+    return -1;
+
+  index->hashes[row] = table_hash_index_hash(type, value);
+  table_hash_index_place(index, row);
+  index->length++;
+  return 0;
+}
+
+/**
+ * \brief Put a row with a known hash into the first free slot of its probe sequence
+ * \param[out] index The hash index
+ * \param[in] row The table row
+ */
+static void table_hash_index_place(table_hash_index *index, int row)
+{
+  int mask = index->capacity - 1;
+  int slot = index->hashes[row] & mask;
+
+  while (index->slots[slot] != -1)
+    slot = (slot + 1) & mask;
+
+  index->slots[slot] = row;
+  index->positions[row] = slot;
+}
+
+/**
+ * \brief Remove a row from a hash index, if it is in it
+ * \param[out] index The hash index
+ * \param[in] row The table row
+ *
+ * The rows probed past the freed slot are moved back into it when their
+ * home slot allows, so that no tombstones are needed.
+ */
+static void table_hash_index_remove(table_hash_index *index, int row)
+{
+  int mask = index->capacity - 1;
+  int hole = index->positions[row];
+
+  if (row >= index->rows_length || hole == -1)
+    return;
+
+  index->slots[hole] = -1;
+  index->positions[row] = -1;
+  index->length--;
+
+  for (int slot = (hole + 1) & mask; index->slots[slot] != -1; slot = (slot + 1) & mask)
+  {
+    int moved = index->slots[slot];
+    int home = index->hashes[moved] & mask;
+
+    /* A row stays when its home slot lies cyclically after the hole, up to its slot */
+    if (hole <= slot ? (home > hole && home <= slot) : (home > hole || home <= slot))
+      continue;
+
+    index->slots[hole] = moved;
+    index->positions[moved] = hole;
+    index->slots[slot] = -1;
+    hole = slot;
+  }
+}
+
+/**
+ * \brief Remove a row from a hash index, moving the rows after it up by one
+ * \param[out] index The hash index
+ * \param[in] row The table row removed
+ */
+static void table_hash_index_shift(table_hash_index *index, int row)
+{
+  if (row >= index->rows_length)
+    return;
+
+  table_hash_index_remove(index, row);
+
+  for (int slot = 0; slot < index->capacity; slot++)
+    if (index->slots[slot] > row)
+      index->slots[slot]--;
+
+  index->rows_length--;
+  memmove(index->hashes + row, index->hashes + row + 1, (index->rows_length - row) * sizeof(uint64_t));
+  memmove(index->positions + row, index->positions + row + 1, (index->rows_length - row) * sizeof(int));
+}
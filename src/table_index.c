@@ -0,0 +1,636 @@
+/**
+ * \file
+ * \brief The table ordered index implementation file
+ *
+ * This file handles ordered indexes. An ordered index keeps the rows of a
+ * column in the order of the column comparator without moving the rows of
+ * the table, so that the rows with values in a range can be visited in
+ * order on a table sorted by another column.
+ *
+ * The rows are kept in blocks of a few hundred rows, a B+-tree of two levels
+ * where the list of blocks is the inner level. A block is found by a binary
+ * search on the value of its last row, and rows are found within a block by
+ * another binary search. Blocks are split when they fill up and merged into
+ * a neighbour when they run low. The index follows the table through a
+ * registered callback, as hash indexes do.
+ */
+#include "table_defs.h"
+
+static const int INDEX_BLOCK_SIZE = 256;
+static const int INDEX_BLOCK_MIN = 64;
+static const int INDEX_BLOCK_MAX = 512;
+
+static void table_index_callback(table *t, int row, int column, table_event_type event_type, void *data);
+static inline const void *table_index_value(const table_index *index, int row);
+static inline int table_index_compare_rows(const table_index *index, int row1, int row2);
+static int table_index_find_block(const table_index *index, int row);
+static int table_index_rebuild(table_index *index);
+static void table_index_invalidate(table_index *index);
+static void table_index_clear(table_index *index);
+static int table_index_reserve_rows(table_index *index, int rows);
+static table_index_block *table_index_add_block(table_index *index, int position);
+static void table_index_remove_block(table_index *index, int position);
+static void table_index_insert(table_index *index, int row);
+static void table_index_split(table_index *index, int position);
+static void table_index_remove(table_index *index, int row);
+static table_index_block *table_index_take(table_index *index, int row);
+static void table_index_balance(table_index *index, table_index_block *block);
+static void table_index_merge(table_index *index, int position);
+static void table_index_shift(table_index *index, int row);
+
+/**
+ * \brief Create an ordered index on a column
+ * \param[out] t The table
+ * \param[in] col The column to index
+ * \return The index, or NULL on failure
+ *
+ * The index is kept in the order of the column comparator, rows with equal
+ * values in row order, and follows every change made through the table.
+ * Rows without a value are not indexed. The index must be dropped with
+ * table_drop_index(), before or after the table is destroyed.
+ */
+table_index *table_create_index(table *t, int col)
+{
+  table_index *index = calloc(1, sizeof(table_index));
+
+  if (!index)
+    return NULL;
+
+  index->t = t;
+  index->col = col;
+  table_register_callback(t, table_index_callback, index,
+                          TABLE_DATA_MODIFIED | TABLE_ROW_ADDED | TABLE_ROW_REMOVED |
+                          TABLE_COLUMN_REMOVED | TABLE_SORTED | TABLE_DESTROYED);
+  if (table_index_rebuild(index))
+  {
+    table_drop_index(index);
+    return NULL;
+  }
+  return index;
+}
+
+/**
+ * \brief Drop an ordered index
+ * \param[in] index The index
+ */
+void table_drop_index(table_index *index)
+{
+  if (!index)
+    return;
+
+  if (index->t)
+    table_unregister_callback(index->t, table_index_callback, index);
+
+  table_index_clear(index);
+  free(index->blocks);
+  free(index->row_blocks);
+  free(index);
+}
+
+/**
+ * \brief Get the number of rows in an ordered index
+ * \param[in] index The index
+ * \return The number of rows with a value
+ */
+int table_index_get_length(const table_index *index)
+{
+  return index->length;
+}
+
+/**
+ * \brief Visit the rows with a value in a range, in order
+ * \param[in] index The index
+ * \param[in] lo The lowest value to visit, or NULL for no lower bound
+ * \param[in] hi The highest value to visit, or NULL for no upper bound
+ * \param[in] visitor The function receiving the rows
+ * \param[in] data The data passed to the visitor
+ * \return The number of rows visited, or -1 if the index could not be rebuilt
+ *
+ * Values are passed as to table_find(), bounds are inclusive. The visitor
+ * must not change the table. The index is rebuilt first if the column
+ * comparator was changed since it was built, or if an allocation failed
+ * while it followed the table.
+ */
+int table_index_range(table_index *index, const void *lo, const void *hi, table_row_visitor visitor, void *data)
+{
+  int first = 0, last, visited = 0;
+  bool seek = lo != NULL;
+
+  if (!index->t || index->col < 0)
+    return 0;
+
+  if (index->comparator != table_get_col_ptr(index->t, index->col)->comparator && table_index_rebuild(index))
+    return -1;
+
+  if (!index->length)
+    return 0;
+
+  if (lo)
+  {
+    /* The first block whose last row is not before the lower bound */
+    last = index->blocks_length;
+    while (first < last)
+    {
+      int middle = first + (last - first) / 2;
+      table_index_block *block = index->blocks[middle];
+      if (index->comparator(lo, table_index_value(index, block->rows[block->length - 1])) > 0)
+        first = middle + 1;
+      else
+        last = middle;
+    }
+  }
+
+  for (int position = 0; first < index->blocks_length; first++, position = 0)
+  {
+    table_index_block *block = index->blocks[first];
+
+    /* Only the first block visited may hold rows before the lower bound */
+    if (seek)
+    {
+      seek = false;
+      last = block->length;
+      while (position < last)
+      {
+        int middle = position + (last - position) / 2;
+        if (index->comparator(lo, table_index_value(index, block->rows[middle])) > 0)
+          position = middle + 1;
+        else
+          last = middle;
+      }
+    }
+
+    for (; position < block->length; position++)
+    {
+      int row = block->rows[position];
+
+      if (hi && index->comparator(table_index_value(index, row), hi) > 0)
+        return visited;
+
+      visited++;
+      if (!visitor(index->t, row, data))
+        return visited;
+    }
+  }
+
+  return visited;
+}
+
+/**
+ * \brief Keep an ordered index current with a change to its table
+ * \param[in] t The table
+ * \param[in] row The row changed, or -1 for many rows
+ * \param[in] column The column changed, or -1 for many columns
+ * \param[in] event_type The change
+ * \param[in] data The index
+ */
+static void table_index_callback(table *t, int row, int column, table_event_type event_type, void *data)
+{
+  table_index *index = data;
+  int rows;
+
+  if (t != index->t)
+    return;
+
+  if (event_type == TABLE_DESTROYED)
+  {
+    table_index_clear(index);
+    index->t = NULL;
+    return;
+  }
+
+  if (index->col < 0)
+    return;
+
+  /* An invalidated index is rebuilt when it is next used, only its column is followed */
+  if (!index->comparator && event_type != TABLE_COLUMN_REMOVED)
+    return;
+
+  switch (event_type)
+  {
+    case TABLE_DATA_MODIFIED:
+      if (row < 0)
+        table_index_rebuild(index);
+      else if (column == index->col)
+      {
+        table_index_remove(index, row);
+        table_index_insert(index, row);
+      }
+      break;
+    case TABLE_ROW_ADDED:
+      /* New rows have no value yet, table_add_row() notifies before counting its row */
+      rows = row + 1 > table_get_row_length(t) ? row + 1 : table_get_row_length(t);
+      if (table_index_reserve_rows(index, rows))
+      {
+        table_index_invalidate(index);
+        break;
+      }
+      for (int i = index->rows_length; i < rows; i++)
+        index->row_blocks[i] = NULL;
+      index->rows_length = rows;
+      break;
+    case TABLE_ROW_REMOVED:
+      if (row < 0)
+        table_index_rebuild(index);
+      else if (row < table_get_row_length(t) && table_row_is_removed(t, row))
+        table_index_remove(index, row);
+      else
+        table_index_shift(index, row);
+      break;
+    case TABLE_COLUMN_REMOVED:
+      if (column < index->col)
+        index->col--;
+      else if (column == index->col)
+      {
+        table_index_clear(index);
+        index->col = -1;
+      }
+      break;
+    case TABLE_SORTED:
+      table_index_rebuild(index);
+      break;
+    default:
+      break;
+  }
+}
+
+/**
+ * \brief Get the value of an indexed row
+ * \param[in] index The index
+ * \param[in] row The table row, which has a value
+ * \return The value pointer
+ */
+static inline const void *table_index_value(const table_index *index, int row)
+{
+  return table_storage_get_value(index->t, row, index->col);
+}
+
+/**
+ * \brief Compare two indexed rows by value, then by row
+ * \param[in] index The index
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than, equal to or greater than zero if row1 is ordered before, with or after row2
+ */
+static inline int table_index_compare_rows(const table_index *index, int row1, int row2)
+{
+  int result = index->comparator(table_index_value(index, row1), table_index_value(index, row2));
+
+  if (!result)
+    result = (row1 > row2) - (row1 < row2);
+  return result;
+}
+
+/**
+ * \brief Find the block a row belongs in
+ * \param[in] index The index, with at least one block
+ * \param[in] row The table row
+ * \return The first block whose last row is ordered after the row, or the last block
+ */
+static int table_index_find_block(const table_index *index, int row)
+{
+  int first = 0, last = index->blocks_length - 1;
+
+  while (first < last)
+  {
+    int middle = first + (last - first) / 2;
+    table_index_block *block = index->blocks[middle];
+    if (table_index_compare_rows(index, block->rows[block->length - 1], row) < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+
+  return first;
+}
+
+/**
+ * \brief Index every row of the column again
+ * \param[out] index The index
+ *
+ * \return 0 on success, or -1 on allocation failure, leaving the index invalidated
+ *
+ * The rows are ordered by table_argsort() and cut into half full blocks.
+ */
+static int table_index_rebuild(table_index *index)
+{
+  table *t = index->t;
+  int row_length = table_get_row_length(t);
+  table_order order = TABLE_ASCENDING;
+  table_sort_spec spec;
+  table_index_block *block = NULL;
+  int *perm;
+
+  table_index_clear(index);
+  if (table_index_reserve_rows(index, row_length))
+  {
+    table_index_invalidate(index);
+    return -1;
+  }
+  for (int row = 0; row < row_length; row++)
+    index->row_blocks[row] = NULL;
+  index->rows_length = row_length;
+
+  if (!row_length)
+  {
+    index->comparator = table_get_col_ptr(t, index->col)->comparator;
+    return 0;
+  }
+
+  perm = malloc((size_t)row_length * sizeof(int));
+  if (!perm)
+  {
+    table_index_invalidate(index);
+    return -1;
+  }
+
+  index->comparator = table_get_col_ptr(t, index->col)->comparator;
+  table_sort_spec_init(&spec, &index->col, &order, 1);
+  table_argsort(t, &spec, perm);
+  table_sort_spec_destroy(&spec);
+
+  for (int i = 0; i < row_length; i++)
+  {
+    int row = perm[i];
+
+    if (!table_storage_has_value(t, row, index->col))
+      continue;
+
+    if (!block || block->length == INDEX_BLOCK_SIZE)
+      block = table_index_add_block(index, index->blocks_length);
+
+    block->rows[block->length++] = row;
+    index->row_blocks[row] = block;
+    index->length++;
+  }
+
+  free(perm);
+  return 0;
+}
+
+/**
+ * \brief Empty an index that can no longer follow its table
+ * \param[out] index The index
+ *
+ * The comparator is forgotten, so that the index is rebuilt before it is
+ * next used.
+ */
+static void table_index_invalidate(table_index *index)
+{
+  table_index_clear(index);
+  index->rows_length = 0;
+  index->comparator = NULL;
+}
+
+/**
+ * \brief Remove every row from an index
+ * \param[out] index The index
+ */
+static void table_index_clear(table_index *index)
+{
+  for (int i = 0; i < index->blocks_length; i++)
+    free(index->blocks[i]);
+
+  for (int row = 0; row < index->rows_length; row++)
+    index->row_blocks[row] = NULL;
+
+  index->blocks_length = 0;
+  index->length = 0;
+}
+
+/**
+ * \brief Make room for the block of a number of rows
+ * \param[out] index The index
+ * \param[in] rows The number of rows
+ * \return 0 on success, or -1 on allocation failure, leaving the rows as they were
+ */
+static int table_index_reserve_rows(table_index *index, int rows)
+{
+  int allocated = index->rows_allocated ? index->rows_allocated : INDEX_BLOCK_SIZE;
+  table_index_block **row_blocks;
+
+  if (rows <= index->rows_allocated)
+    return 0;
+
+  while (allocated < rows)
+    allocated *= 2;
+
+  row_blocks = realloc(index->row_blocks, (size_t)allocated * sizeof(table_index_block*));
+  if (!row_blocks)
+    return -1;
+
+  index->row_blocks = row_blocks;
+  index->rows_allocated = allocated;
+  return 0;
+}
+
+/**
+ * \brief Add an empty block to an index
+ * \param[out] index The index
+ * \param[in] position The position of the new block
+ * \return The new block
+ */
+static table_index_block *table_index_add_block(table_index *index, int position)
+{
+  table_index_block *block = malloc(sizeof(table_index_block) + INDEX_BLOCK_MAX * sizeof(int));
+
+  if (index->blocks_length == index->blocks_allocated)
+  {
+    index->blocks_allocated = index->blocks_allocated ? 2 * index->blocks_allocated : 16;
+    index->blocks = realloc(index->blocks, index->blocks_allocated * sizeof(table_index_block*));
+  }
+
+  memmove(index->blocks + position + 1, index->blocks + position,
+          (index->blocks_length - position) * sizeof(table_index_block*));
+  index->blocks[position] = block;
+  index->blocks_length++;
+
+  block->length = 0;
+  return block;
+}
+
+/**
+ * \brief Remove a block from an index and free it
+ * \param[out] index The index
+ * \param[in] position The position of the block
+ */
+static void table_index_remove_block(table_index *index, int position)
+{
+  free(index->blocks[position]);
+  index->blocks_length--;
+  memmove(index->blocks + position, index->blocks + position + 1,
+          (index->blocks_length - position) * sizeof(table_index_block*));
+}
+
+/**
+ * \brief Add a row to an index, if it has a value
+ * \param[out] index The index
+ * \param[in] row The table row
+ */
+static void table_index_insert(table_index *index, int row)
+{
+  table_index_block *block;
+  int position, first = 0, last;
+
+  index->row_blocks[row] = NULL;
+  if (!table_storage_has_value(index->t, row, index->col))
+    return;
+
+  if (!index->blocks_length)
+    table_index_add_block(index, 0);
+
+  position = table_index_find_block(index, row);
+  block = index->blocks[position];
+
+  /* The first row of the block ordered after the new row */
+  last = block->length;
+  while (first < last)
+  {
+    int middle = first + (last - first) / 2;
+    if (table_index_compare_rows(index, block->rows[middle], row) < 0)
+      first = middle + 1;
+    else
+      last = middle;
+  }
+
+  memmove(block->rows + first + 1, block->rows + first, (block->length - first) * sizeof(int));
+  block->rows[first] = row;
+  block->length++;
+  index->row_blocks[row] = block;
+  index->length++;
+
+  if (block->length == INDEX_BLOCK_MAX)
+    table_index_split(index, position);
+}
+
+/**
+ * \brief Split a full block in two
+ * \param[out] index The index
+ * \param[in] position The position of the block
+ */
+static void table_index_split(table_index *index, int position)
+{
+  table_index_block *block = index->blocks[position];
+  table_index_block *next = table_index_add_block(index, position + 1);
+  int half = block->length / 2;
+
+  next->length = block->length - half;
+  memcpy(next->rows, block->rows + half, next->length * sizeof(int));
+  block->length = half;
+
+  for (int i = 0; i < next->length; i++)
+    index->row_blocks[next->rows[i]] = next;
+}
+
+/**
+ * \brief Remove a row from an index, if it is in it
+ * \param[out] index The index
+ * \param[in] row The table row
+ */
+static void table_index_remove(table_index *index, int row)
+{
+  table_index_block *block = table_index_take(index, row);
+
+  if (block)
+    table_index_balance(index, block);
+}
+
+/**
+ * \brief Take a row out of its block, leaving the block as it is
+ * \param[out] index The index
+ * \param[in] row The table row
+ * \return The block of the row, or NULL if the row is not in the index
+ *
+ * The row is found through its block, its value may already have changed.
+ */
+static table_index_block *table_index_take(table_index *index, int row)
+{
+  table_index_block *block = row < index->rows_length ? index->row_blocks[row] : NULL;
+  int i = 0;
+
+  if (!block)
+    return NULL;
+
+  while (block->rows[i] != row)
+    i++;
+
+  memmove(block->rows + i, block->rows + i + 1, (block->length - i - 1) * sizeof(int));
+  block->length--;
+  index->row_blocks[row] = NULL;
+  index->length--;
+  return block;
+}
+
+/**
+ * \brief Free a block left empty, or merge a block that runs low
+ * \param[out] index The index
+ * \param[in] block The block rows were taken from
+ */
+static void table_index_balance(table_index *index, table_index_block *block)
+{
+  int position;
+
+  if (!block->length)
+  {
+    for (position = 0; index->blocks[position] != block; position++)
+      ;
+    table_index_remove_block(index, position);
+  }
+  else if (block->length < INDEX_BLOCK_MIN && index->blocks_length > 1)
+    table_index_merge(index, table_index_find_block(index, block->rows[0]));
+}
+
+/**
+ * \brief Merge a block that runs low with a neighbour, if they fit in one block
+ * \param[out] index The index
+ * \param[in] position The position of the block
+ */
+static void table_index_merge(table_index *index, int position)
+{
+  table_index_block *block, *next;
+
+  if (position == index->blocks_length - 1)
+    position--;
+
+  block = index->blocks[position];
+  next = index->blocks[position + 1];
+  if (block->length + next->length >= INDEX_BLOCK_MAX)
+    return;
+
+  memcpy(block->rows + block->length, next->rows, next->length * sizeof(int));
+  for (int i = 0; i < next->length; i++)
+    index->row_blocks[next->rows[i]] = block;
+
+  block->length += next->length;
+  table_index_remove_block(index, position + 1);
+}
+
+/**
+ * \brief Remove a row from an index, moving the rows after it up by one
+ * \param[out] index The index
+ * \param[in] row The table row removed
+ */
+static void table_index_shift(table_index *index, int row)
+{
+  table_index_block *block;
+
+  if (row >= index->rows_length)
+    return;
+
+  /* The rows after the removed row must be renumbered before any value is compared */
+  block = table_index_take(index, row);
+
+  for (int position = 0; position < index->blocks_length; position++)
+  {
+    table_index_block *current = index->blocks[position];
+    for (int i = 0; i < current->length; i++)
+      if (current->rows[i] > row)
+        current->rows[i]--;
+  }
+
+  index->rows_length--;
+  memmove(index->row_blocks + row, index->row_blocks + row + 1,
+          (index->rows_length - row) * sizeof(table_index_block*));
+
+  if (block)
+    table_index_balance(index, block);
+}
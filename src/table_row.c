@@ -6,10 +6,9 @@
  */
 #include "table_defs.h"
 
-static void table_add_row_block(table *t);
-static void table_remove_row_block(table *t);
 static int table_row_add(table *t);
 static int table_row_rem(table *t, int row_num);
+static void table_row_tombstone(table *t, int row_index);
 
 /**
  * \brief Initialize a table row
@@ -19,7 +18,46 @@ static int table_row_rem(table *t, int row_num);
 void table_row_init(table *t, int row_index)
 {
   table_row *row = table_get_row_ptr(t, row_index);
-  row->cells = malloc(sizeof(table_cell) * t->columns_allocated);
+  size_t size = sizeof(table_cell) * t->cells_allocated;
+
+  row->cells_allocated = t->cells_allocated;
+  row->removed = false;
+  if (!size)
+    row->cells = NULL;
+  else if (t->slab_size)
+    row->cells = table_arena_alloc(t, size, TABLE_ARENA_ALIGNMENT);
+  else
+    row->cells = malloc(size);
+}
+
+/**
+ * \brief Widen a row to the number of cells allocated by the table
+ * \param[out] t The table
+ * \param[in] row_index The table row
+ *
+ * Adding a column does not touch existing rows, a row is only widened once
+ * a value is stored in one of the new cells.
+ */
+void table_row_widen(table *t, int row_index)
+{
+  table_row *row = table_get_row_ptr(t, row_index);
+
+  if (row->cells_allocated >= t->cells_allocated)
+    return;
+
+  if (t->slab_size)
+  {
+    table_cell *cells = table_arena_alloc(t, sizeof(table_cell) * t->cells_allocated, TABLE_ARENA_ALIGNMENT);
+    if (row->cells)
+      memcpy(cells, row->cells, sizeof(table_cell) * row->cells_allocated);
+    row->cells = cells;
+  }
+  else
+  {
+    row->cells = realloc(row->cells, sizeof(table_cell) * t->cells_allocated);
+  }
+
+  row->cells_allocated = t->cells_allocated;
 }
 
 /**
@@ -35,10 +73,45 @@ void table_row_destroy(table *t, int row_index)
   for (int column_index = 0; column_index < column_length; column_index++)
     table_cell_destroy(t, row_index, column_index);
   
-  if (row_ptr->cells)
+  if (row_ptr->cells && !t->slab_size)
     free(row_ptr->cells);
 }
 
+/**
+ * \brief Drop the rows past a number of rows, undoing table_append_rows()
+ * \param[out] t The table
+ * \param[in] length The number of rows to keep, the rows past it must have no values
+ *
+ * Callbacks receive a single TABLE_ROW_REMOVED notification with a row of -1.
+ */
+void table_truncate_rows(table *t, int length)
+{
+  int row_length = table_get_row_length(t);
+  int column_length = table_get_column_length(t);
+  size_t capacity;
+
+  if (length >= row_length)
+    return;
+
+  for (int row_index = length; row_index < row_length; row_index++)
+  {
+    table_row *row = table_get_row_ptr(t, row_index);
+    if (row->cells && !t->slab_size)
+      free(row->cells);
+  }
+
+  for (int column_index = 0; column_index < column_length; column_index++)
+    table_get_col_ptr(t, column_index)->null_count -= row_length - length;
+
+  t->rows_length = length;
+
+  capacity = table_shrink_capacity(t, t->rows_allocated, t->row_block, t->rows_reserved, length);
+  if (capacity != t->rows_allocated)
+    table_resize_rows(t, capacity);
+
+  table_notify(t, -1, -1, TABLE_ROW_REMOVED);
+}
+
 /**
  * \brief Get the number of rows in the table
  * \param[in] table The table to examine
@@ -56,50 +129,262 @@ int table_get_row_length(const table *t)
  */
 int table_add_row(table *t)
 {
-  if(!(table_get_row_length(t) % t->row_block))
-    table_add_row_block(t);
+  if((size_t)table_get_row_length(t) == t->rows_allocated)
+    table_resize_rows(t, table_grow_capacity(t, t->rows_allocated, t->row_block, t->rows_allocated + 1));
 
   table_row_add(t);
   table_notify(t, table_get_row_length(t), -1, TABLE_ROW_ADDED);
   return t->rows_length++;
 }
 
+/**
+ * \brief Add several new rows to the table
+ * \param[in] t The table to be acted on
+ * \param[in] length The number of rows
+ * \return The row number of the first new row, or -1 if the length is negative
+ *
+ * The new rows have no values. Callbacks receive a single TABLE_ROW_ADDED
+ * notification with a row of -1.
+ */
+int table_append_rows(table *t, int length)
+{
+  int first = table_get_row_length(t);
+  int column_length = table_get_column_length(t);
+
+  if (length < 0)
+    return -1;
+
+  if ((size_t)(first + length) > t->rows_allocated)
+    table_resize_rows(t, table_grow_capacity(t, t->rows_allocated, t->row_block, first + length));
+
+  /* The validity bits past the last row are already clear */
+  for (int row_index = first; row_index < first + length; row_index++)
+    table_row_init(t, row_index);
+
+  /* A borrowed buffer only holds the rows it was borrowed with */
+  for (int column_index = 0; column_index < column_length; column_index++)
+  {
+    table_storage_own_column(t, column_index);
+    table_get_col_ptr(t, column_index)->null_count += length;
+  }
+
+  t->rows_length += length;
+  table_notify(t, -1, -1, TABLE_ROW_ADDED);
+  return first;
+}
+
 /**
  * \brief Delete a row from the table
  * \param[in] t The table to be acted on
  * \param[in] row The table row
- * \return A corresponding int
+ * \return 0 on success, or -1 if the row is out of range or already removed
  */
 int table_remove_row(table *t, int row)
 {
+  size_t capacity;
+
+  if (row < 0 || row >= table_get_row_length(t) || table_row_is_removed(t, row))
+    return -1;
+
+  /* Tombstoned rows keep their place until the table is compacted */
+  if (t->tombstone_threshold > 0.0)
+  {
+    table_row_tombstone(t, row);
+    table_notify(t, row, -1, TABLE_ROW_REMOVED);
+
+    if (t->rows_removed > t->tombstone_threshold * table_get_row_length(t))
+      table_compact_rows(t);
+    return 0;
+  }
+
   table_row_rem(t, row);
   t->rows_length--;
 
-  if(!(table_get_row_length(t) % t->row_block))
-    table_remove_row_block(t);
+  capacity = table_shrink_capacity(t, t->rows_allocated, t->row_block, t->rows_reserved, table_get_row_length(t));
+  if(capacity != t->rows_allocated)
+    table_resize_rows(t, capacity);
 
   table_notify(t, row, -1, TABLE_ROW_REMOVED);
   return 0;
 }
 
 /**
- * \brief Add a block of rows
- * \param[in] table The table
+ * \brief Delete several rows from the table
+ * \param[in] t The table to be acted on
+ * \param[in] rows The table rows, in any order
+ * \param[in] length The number of rows
+ * \return The number of rows removed, or -1 if a row is out of range
+ *
+ * The table is compacted in a single pass and callbacks receive a single
+ * TABLE_ROW_REMOVED notification with a row of -1.
+ */
+int table_remove_rows(table *t, const int *rows, int length)
+{
+  int row_length = table_get_row_length(t);
+  int removed = t->rows_removed;
+
+  for (int i = 0; i < length; i++)
+    if (rows[i] < 0 || rows[i] >= row_length)
+      return -1;
+
+  for (int i = 0; i < length; i++)
+    table_row_tombstone(t, rows[i]);
+
+  removed = t->rows_removed - removed;
+  table_compact_rows(t);
+  return removed;
+}
+
+/**
+ * \brief Delete every row matching a predicate
+ * \param[in] t The table to be acted on
+ * \param[in] predicate The predicate selecting the rows to delete
+ * \param[in] data The predicate data
+ * \return The number of rows removed
+ *
+ * The table is compacted in a single pass and callbacks receive a single
+ * TABLE_ROW_REMOVED notification with a row of -1.
  */
-static void table_add_row_block(table *t)
+int table_remove_rows_where(table *t, table_row_predicate predicate, void *data)
 {
-  t->rows_allocated += t->row_block;
-  t->rows = realloc(t->rows, sizeof(table_row) * t->rows_allocated);
+  int row_length = table_get_row_length(t);
+  int removed = t->rows_removed;
+
+  for (int row_index = 0; row_index < row_length; row_index++)
+    if (!table_row_is_removed(t, row_index) && predicate(t, row_index, data))
+      table_row_tombstone(t, row_index);
+
+  removed = t->rows_removed - removed;
+  table_compact_rows(t);
+  return removed;
 }
 
 /**
- * \brief Remove a block of rows
- * \param[in] table The table
+ * \brief Set the fraction of tombstoned rows that triggers compaction
+ * \param[out] t The table
+ * \param[in] threshold The fraction between 0 and 1, 0 removes rows immediately
+ * \return 0 on success, or -1 if the threshold is out of range
+ *
+ * With a threshold, table_remove_row() only destroys the values of a row and
+ * marks it as removed, leaving every row index in place. The row reads as
+ * having no values until the table is compacted, which happens once more
+ * than the threshold fraction of the rows are removed, or on request with
+ * table_compact_rows(). A threshold of 1 never compacts on its own.
  */
-static void table_remove_row_block(table *t)
+int table_set_tombstone_threshold(table *t, double threshold)
 {
-  t->rows_allocated -= t->row_block;
-  t->rows = realloc(t->rows, sizeof(table_row) * t->rows_allocated);
+  if (threshold < 0.0 || threshold > 1.0)
+    return -1;
+
+  t->tombstone_threshold = threshold;
+  if (t->rows_removed > threshold * table_get_row_length(t))
+    table_compact_rows(t);
+
+  return 0;
+}
+
+/**
+ * \brief Get the fraction of tombstoned rows that triggers compaction
+ * \param[in] t The table
+ * \return The threshold, 0 when rows are removed immediately
+ */
+double table_get_tombstone_threshold(const table *t)
+{
+  return t->tombstone_threshold;
+}
+
+/**
+ * \brief Determine if a row is a tombstone awaiting compaction
+ * \param[in] t The table
+ * \param[in] row The table row
+ * \return TRUE or FALSE
+ */
+bool table_row_is_removed(const table *t, int row)
+{
+  return table_get_row_ptr(t, row)->removed;
+}
+
+/**
+ * \brief Remove every tombstoned row from the table
+ * \param[in] t The table to be acted on
+ * \return The number of rows removed
+ *
+ * The remaining rows are moved down in a single pass and callbacks receive a
+ * single TABLE_ROW_REMOVED notification with a row of -1.
+ */
+int table_compact_rows(table *t)
+{
+  int row_length = table_get_row_length(t);
+  int removed = t->rows_removed, kept = 0;
+  size_t capacity;
+
+  if (!removed)
+    return 0;
+
+  table_storage_compact_rows(t);
+
+  for (int row_index = 0; row_index < row_length; row_index++)
+  {
+    table_row *row = table_get_row_ptr(t, row_index);
+    if (!row->removed)
+      table_set_row_ptr(t, kept++, row);
+    else if (row->cells && !t->slab_size)
+      free(row->cells);
+  }
+
+  t->rows_length = kept;
+  t->rows_removed = 0;
+
+  capacity = table_shrink_capacity(t, t->rows_allocated, t->row_block, t->rows_reserved, kept);
+  if (capacity != t->rows_allocated)
+    table_resize_rows(t, capacity);
+
+  table_notify(t, -1, -1, TABLE_ROW_REMOVED);
+  return removed;
+}
+
+/**
+ * \brief Reserve room for a number of rows
+ * \param[out] t The table
+ * \param[in] rows The number of rows to keep allocated
+ * \return 0 on success, or -1 if the number of rows is negative
+ */
+int table_reserve_rows(table *t, int rows)
+{
+  if (rows < 0)
+    return -1;
+
+  t->rows_reserved = rows;
+  if ((size_t)rows > t->rows_allocated)
+    table_resize_rows(t, rows);
+
+  return 0;
+}
+
+/**
+ * \brief Reallocate the rows of the table
+ * \param[out] t The table
+ * \param[in] allocated The number of rows to allocate
+ */
+void table_resize_rows(table *t, size_t allocated)
+{
+  size_t previous_allocated = t->rows_allocated;
+
+  if (allocated == previous_allocated)
+    return;
+
+  t->rows_allocated = allocated;
+  if (allocated)
+  {
+    t->rows = realloc(t->rows, sizeof(table_row) * allocated);
+  }
+  else
+  {
+    free(t->rows);
+    t->rows = NULL;
+  }
+
+  table_storage_resize_rows(t, previous_allocated);
 }
 
 /**
@@ -115,7 +400,10 @@ static int table_row_add(table *t)
   table_row_init(t, rows_length);
 
   for(int column_index = 0; column_index < columns_length; column_index++)
+  {
     table_cell_init(t, rows_length, column_index);
+    table_get_col_ptr(t, column_index)->null_count++;
+  }
 
   return 0;
 }
@@ -128,38 +416,12 @@ static int table_row_add(table *t)
  */
 static int table_row_rem(table *t, int row_num)
 {
-  table_row* row;
-  int num_rows, num_cols, i;
+  int num_rows, i;
 
   num_rows = table_get_row_length(t);
-  num_cols = table_get_column_length(t);
 
-  /* Free the cell values of the row to be deleted */
-  for(i = 0; i < num_cols; i++)
-  {
-    table_data_type type;
-    table_cell* cell;
-    type = table_get_column_data_type(t, i);
-
-    /* We skip columns that are of TABLE_PTR type */
-    if(type == TABLE_PTR)
-    {
-      continue;
-    }
-
-    cell = table_get_cell_ptr(t, row_num, i);
-    if(cell->value)
-    {
-      free(cell->value);
-    }
-  }
-
-  /* Free the cells */
-  row = table_get_row_ptr(t, row_num);
-  if(row->cells)
-  {
-    free(row->cells);
-  }
+  /* Free the cell values and cells of the row to be deleted */
+  table_row_destroy(t, row_num);
 
   /* Shift rows up and overwrite the deleted row */
   for(i = row_num; i < (num_rows - 1); i++)
@@ -167,9 +429,32 @@ static int table_row_rem(table *t, int row_num)
     memcpy(t->rows + i, t->rows + i + 1, sizeof(table_row));
   }
 
+  /* Shift the column storage values up */
+  table_storage_remove_row(t, row_num);
+
   return 0;
 }
 
+/**
+ * \brief Destroy the values of a row and mark it as removed
+ * \param[out] t The table to be acted on
+ * \param[in] row_index The row number
+ */
+static void table_row_tombstone(table *t, int row_index)
+{
+  int column_length = table_get_column_length(t);
+  table_row *row = table_get_row_ptr(t, row_index);
+
+  if (row->removed)
+    return;
+
+  for (int column_index = 0; column_index < column_length; column_index++)
+    table_cell_nullify(t, row_index, column_index);
+
+  row->removed = true;
+  t->rows_removed++;
+}
+
 /**
  * \brief Get the pointer of a particular row
  * \return The table row pointer
@@ -188,3 +473,25 @@ void table_set_row_ptr(table *t, int row, table_row *row_ptr)
 {
 	t->rows[row] = *row_ptr;
 }
+
+/**
+ * \brief Reorder a range of rows
+ * \param[out] t The table
+ * \param[in] first The first row of the range
+ * \param[in] order The source row of each row in the range
+ * \param[in] length The number of rows in the range
+ */
+void table_permute_rows(table *t, int first, const int *order, int length)
+{
+  table_row *rows = malloc(sizeof(table_row) * length);
+  int i;
+
+  for (i = 0; i < length; i++)
+    rows[i] = *table_get_row_ptr(t, order[i]);
+
+  for (i = 0; i < length; i++)
+    table_set_row_ptr(t, first + i, &rows[i]);
+
+  free(rows);
+  table_storage_permute_rows(t, first, order, length);
+}
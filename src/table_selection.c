@@ -0,0 +1,147 @@
+/**
+ * \file
+ * \brief The table selection implementation file
+ *
+ * This file handles selections. A selection is a vector of table rows in
+ * ascending order, filled in one pass by table_find_all() and read back or
+ * handed on to other table operations.
+ */
+#include "table_defs.h"
+
+static const int SELECTION_BLOCK = 64;
+
+/**
+ * \brief Initialize an empty selection
+ * \param[out] selection The selection
+ */
+void table_selection_init(table_selection *selection)
+{
+  selection->t = NULL;
+  selection->rows = NULL;
+  selection->length = 0;
+  selection->allocated = 0;
+  selection->generation = 0;
+}
+
+/**
+ * \brief Destroy a selection
+ * \param[out] selection The selection
+ */
+void table_selection_destroy(table_selection *selection)
+{
+  free(selection->rows);
+  table_selection_init(selection);
+}
+
+/**
+ * \brief Empty a selection before rows of a table are selected into it
+ * \param[out] selection The selection
+ * \param[in] t The table the rows are selected from
+ *
+ * The rows allocated are kept, so that a selection can be refilled without
+ * allocating.
+ */
+void table_selection_reset(table_selection *selection, const table *t)
+{
+  selection->t = t;
+  selection->length = 0;
+  selection->generation = t->generation;
+}
+
+/**
+ * \brief Add a row to a selection
+ * \param[out] selection The selection
+ * \param[in] row The row, after every row already selected
+ * \return 0 on success, -1 on allocation failure
+ */
+int table_selection_add(table_selection *selection, int row)
+{
+  if (selection->length == selection->allocated)
+  {
+    size_t allocated = table_grow_capacity(selection->t, selection->allocated, SELECTION_BLOCK, selection->length + 1);
+    int *rows = realloc(selection->rows, allocated * sizeof(int));
+
+    if (!rows)
+      return -1;
+
+    selection->rows = rows;
+    selection->allocated = (int)allocated;
+  }
+
+  selection->rows[selection->length++] = row;
+  return 0;
+}
+
+/**
+ * \brief Determine if a selection still refers to the rows of its table
+ * \param[in] selection The selection
+ * \return TRUE or FALSE
+ *
+ * A valid selection may no longer match the values it was selected by when
+ * they have been set since.
+ */
+bool table_selection_is_valid(const table_selection *selection)
+{
+  return selection->t && selection->generation == selection->t->generation &&
+         (!selection->length || selection->rows[selection->length - 1] < table_get_row_length(selection->t));
+}
+
+/**
+ * \brief Get the number of rows in a selection
+ * \param[in] selection The selection
+ * \return The number of rows
+ */
+int table_selection_get_length(const table_selection *selection)
+{
+  return selection->length;
+}
+
+/**
+ * \brief Get a row of a selection
+ * \param[in] selection The selection
+ * \param[in] index The index in the selection
+ * \return The table row, to read with table_get() and friends
+ */
+int table_selection_get_row(const table_selection *selection, int index)
+{
+  return selection->rows[index];
+}
+
+/**
+ * \brief Determine if a row is selected
+ * \param[in] selection The selection
+ * \param[in] row The table row
+ * \return TRUE or FALSE
+ */
+bool table_selection_contains(const table_selection *selection, int row)
+{
+  int low = 0, high = selection->length;
+
+  while (low < high)
+  {
+    int middle = low + (high - low) / 2;
+    if (selection->rows[middle] < row)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  return low < selection->length && selection->rows[low] == row;
+}
+
+/**
+ * \brief Delete the rows of a selection
+ * \param[in] t The table to be acted on
+ * \param[in] selection The selection, of rows of the table
+ * \return The number of rows removed, or -1 if the selection is stale
+ *
+ * The table is compacted once, as with table_remove_rows(). The selection
+ * is stale afterwards.
+ */
+int table_remove_selection(table *t, const table_selection *selection)
+{
+  if (selection->t != t || !table_selection_is_valid(selection))
+    return -1;
+
+  return table_remove_rows(t, selection->rows, selection->length);
+}
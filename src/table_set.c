@@ -6,6 +6,8 @@
  */
 #include "table_defs.h"
 
+static int table_check_block(const table *t, int first_row, int first_col, int nrows, int ncols, const table_data_type *types);
+
 /**
  * \brief Set a cell value in the table
  * \param[in] table The table to be modified
@@ -18,362 +20,10 @@
 int table_set(table *t, int row, int col, void *value, table_data_type data_type)
 {
   int retval = -1;
-  table_cell *cell_ptr = table_get_cell_ptr(t, row, col);
   table_column *col_data_ptr = table_get_col_ptr(t, col);
 
-  switch(data_type)
-  {
-  case TABLE_BOOL:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(bool));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(bool));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_INT:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(int));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(int));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UINT:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(unsigned int));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(unsigned int));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_INT8:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(int8_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(int8_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UINT8:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(uint8_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(uint8_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_INT16:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(int16_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(int16_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UINT16:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(uint16_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(uint16_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_INT32:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(int32_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(int32_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UINT32:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(uint32_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(uint32_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_INT64:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(int64_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(int64_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UINT64:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(uint64_t));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(uint64_t));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_SHORT:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(short));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(short));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_USHORT:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(unsigned short));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(unsigned short));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_LONG:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(long));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(long));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_ULONG:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(unsigned long));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(unsigned long));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_LLONG:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(long long));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(long long));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_ULLONG:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(unsigned long long));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(unsigned long long));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_FLOAT:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(float));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(float));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_DOUBLE:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(double));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(double));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_LDOUBLE:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(long double));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(long double));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_STRING:
-    if(col_data_ptr->type == data_type)
-    {
-      size_t size = strlen(value);
-      cell_ptr->value = realloc(cell_ptr->value, size + 1);
-
-      if(cell_ptr->value)
-      {
-        strcpy(cell_ptr->value, value);
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_CHAR:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(char));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(char));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_UCHAR:
-    if(col_data_ptr->type == data_type)
-    {
-      if(!cell_ptr->value)
-      {
-        cell_ptr->value = malloc(sizeof(unsigned char));
-      }
-
-      if(cell_ptr->value)
-      {
-        memcpy(cell_ptr->value, value, sizeof(unsigned char));
-        retval = 0;
-      }
-    }
-    break;
-  case TABLE_PTR:
-    if(col_data_ptr->type == data_type)
-    {
-      cell_ptr->value = value;
-      retval = 0;
-    }
-    break;
-  }
+  if(col_data_ptr->type == data_type)
+    retval = table_storage_set(t, row, col, value);
 
   if(0 == retval)
   {
@@ -383,6 +33,100 @@ int table_set(table *t, int row, int col, void *value, table_data_type data_type
   return retval;
 }
 
+/**
+ * \brief Set a rectangular block of cells from a row major buffer
+ * \param[in] t The table to be modified
+ * \param[in] first_row The first row of the block
+ * \param[in] first_col The first column of the block
+ * \param[in] nrows The number of rows in the block
+ * \param[in] ncols The number of columns in the block
+ * \param[in] buf The values, each row packs one value of every column in order
+ * \param[in] types The data type of each column in the block
+ * \return A corresponding int
+ *
+ * Strings and pointers are passed as pointers, NULL leaves a cell without a
+ * value. Callbacks receive a single TABLE_DATA_MODIFIED notification with a
+ * row and column of -1.
+ */
+int table_set_block(table *t, int first_row, int first_col, int nrows, int ncols, const void *buf, const table_data_type *types)
+{
+  size_t stride = 0, offset = 0;
+
+  if (table_check_block(t, first_row, first_col, nrows, ncols, types))
+    return -1;
+
+  for (int col = 0; col < ncols; col++)
+    stride += table_get_data_type_size(types[col]);
+
+  for (int col = 0; col < ncols; col++)
+  {
+    if (table_storage_set_range(t, first_row, first_col + col, nrows, (const char*)buf + offset, stride))
+      return -1;
+    offset += table_get_data_type_size(types[col]);
+  }
+
+  table_notify(t, -1, -1, TABLE_DATA_MODIFIED);
+  return 0;
+}
+
+/**
+ * \brief Set a rectangular block of cells from a column major buffer
+ * \param[in] t The table to be modified
+ * \param[in] first_row The first row of the block
+ * \param[in] first_col The first column of the block
+ * \param[in] nrows The number of rows in the block
+ * \param[in] ncols The number of columns in the block
+ * \param[in] buf The values, each column packs one value of every row in order
+ * \param[in] types The data type of each column in the block
+ * \return A corresponding int
+ *
+ * Strings and pointers are passed as pointers, NULL leaves a cell without a
+ * value. Callbacks receive a single TABLE_DATA_MODIFIED notification with a
+ * row and column of -1.
+ */
+int table_set_block_column_major(table *t, int first_row, int first_col, int nrows, int ncols, const void *buf, const table_data_type *types)
+{
+  size_t offset = 0;
+
+  if (table_check_block(t, first_row, first_col, nrows, ncols, types))
+    return -1;
+
+  for (int col = 0; col < ncols; col++)
+  {
+    size_t size = table_get_data_type_size(types[col]);
+
+    if (table_storage_set_range(t, first_row, first_col + col, nrows, (const char*)buf + offset, size))
+      return -1;
+    offset += size * nrows;
+  }
+
+  table_notify(t, -1, -1, TABLE_DATA_MODIFIED);
+  return 0;
+}
+
+/**
+ * \brief Validate a rectangular block of cells
+ * \param[in] t The table
+ * \param[in] first_row The first row of the block
+ * \param[in] first_col The first column of the block
+ * \param[in] nrows The number of rows in the block
+ * \param[in] ncols The number of columns in the block
+ * \param[in] types The data type of each column in the block
+ * \return 0 if the block lies within the table and every type matches its column, -1 otherwise
+ */
+static int table_check_block(const table *t, int first_row, int first_col, int nrows, int ncols, const table_data_type *types)
+{
+  if (first_row < 0 || first_col < 0 || nrows < 0 || ncols < 0 ||
+      first_row + nrows > table_get_row_length(t) || first_col + ncols > table_get_column_length(t))
+    return -1;
+
+  for (int col = 0; col < ncols; col++)
+    if (table_get_column_data_type(t, first_col + col) != types[col])
+      return -1;
+
+  return 0;
+}
+
 /**
  * \brief Set a boolean value in the table
  * \param[in] t The table to be acted on
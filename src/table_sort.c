@@ -5,6 +5,15 @@
  * \author Steve Gerbino
  * 
  * This file handles table sort implementations. The table sort implementation uses a merge sort algorithm.
+ * Rows are sorted by index: the sort produces a permutation of the row indices, which is applied to the table
+ * once at the end, so that no row or column value is moved more than once. The merge sort is bottom-up, with
+ * runs of a few rows sorted by insertion first, and merges back and forth between the permutation and a
+ * single scratch buffer.
+ *
+ * When every sort column holds fixed width numbers and uses its default comparator, the rows are instead
+ * sorted by a least significant digit radix sort. Each value is mapped to an unsigned key that orders like
+ * the value, and the rows are distributed by one byte of the keys at a time, from the last sort column to
+ * the first, skipping the bytes that are the same for every row.
  * 
  * In computer science, merge sort (also commonly spelled mergesort) is an O(n log n) comparison-based sorting algorithm. 
  * Most implementations produce a stable sort, which means that the implementation preserves the input order of equal 
@@ -15,11 +24,102 @@
  * \a Source: <a href="https://en.wikipedia.org/wiki/Merge_sort">Merge sort - Wikipedia, the free encyclopedia</a>
  */
 #include "table_defs.h"
+#include <limits.h>
+#ifdef TABLE_THREADS
+#include <pthread.h>
+#endif
 
-static void table_merge_sort_rows(table *t, int col, int first, int last, table_order order);
-static void table_merge_sort_split_rows(table *t, table_row *sorted_rows, int col, int first, int last, table_order order);
-static void table_merge_sort_merge_rows(table *t, table_row *sorted_rows, int col, int first, int middle, int last, table_order order);
-static void table_merge_sort_copy_rows(table *t, int first, int last, table_row *sorted_rows);
+/* The mask of the low bytes of a radix key */
+#define TABLE_RADIX_MASK(size) ((size) >= sizeof(uint64_t) ? ~(uint64_t)0 : ((uint64_t)1 << ((size) * 8)) - 1)
+
+/* The radix key of a signed value, its sign bit flipped */
+#define TABLE_RADIX_SIGNED(value) \
+   (((uint64_t)(int64_t)(value) ^ ((uint64_t)1 << (sizeof(value) * 8 - 1))) & TABLE_RADIX_MASK(sizeof(value)))
+
+/**
+ * \brief A sort key, a column and the order to sort it in
+ */
+typedef struct table_sort_key
+{
+   const table *t; /**< The table being sorted */
+   int col; /**< The column to sort by */
+   table_order order; /**< The order to sort the column in */
+   table_comparator compare; /**< The column comparator function */
+   bool default_comparator; /**< Whether rows without a value are set aside instead of compared */
+   table_column_view view; /**< A view of the column, with a NULL base for row storage */
+} table_sort_key;
+
+/**
+ * \brief The sort keys ordering a group of rows
+ */
+typedef struct table_sort_keys
+{
+   const table_sort_key *keys; /**< The sort keys, most significant first */
+   int length; /**< The number of sort keys */
+   bool first_valid; /**< Whether every row has a value for the first key */
+} table_sort_keys;
+
+/**
+ * \brief The sort keys of a sort specification, for sorting rows from other files
+ */
+struct table_sort_context
+{
+   table_sort_key *keys; /**< The sort keys, most significant first */
+   table_sort_keys sort_keys; /**< The sort keys compared by table_sort_context_compare() */
+};
+
+static const int INSERTION_SORT_CUTOFF = 16;
+static const int RADIX_SORT_CUTOFF = 256;
+static const int PARALLEL_SORT_CUTOFF = 4096;
+
+/**
+ * \brief A share of a parallel sort run by one thread
+ *
+ * A task either sorts the rows from first to last, or merges the runs from
+ * first to middle and from middle to last, producing the merged rows from
+ * output_first to output_last, counted from first.
+ */
+typedef struct table_sort_task
+{
+   const table_sort_key *keys; /**< The sort keys */
+   int num_keys; /**< The number of sort keys */
+   int *src; /**< The row indices to sort or merge */
+   int *dst; /**< The scratch buffer, or the row indices to merge into */
+   int first; /**< The index of the first row */
+   int middle; /**< The index of the first row of the second run */
+   int last; /**< The index past the last row */
+   int output_first; /**< The first merged row of the task */
+   int output_last; /**< The merged row past the last of the task */
+} table_sort_task;
+
+static void table_sort_key_init(table_sort_key *key, const table *t, int col, table_order order);
+static inline void *table_sort_get(const table_sort_key *key, int row);
+static inline int table_sort_compare_values(const table_sort_key *key, int row1, int row2);
+static inline int table_sort_compare_rows(const table_sort_key *key, int row1, int row2);
+static inline int table_sort_compare(const table_sort_keys *keys, int row1, int row2);
+static inline int table_top_k_compare(const table_sort_keys *keys, int row1, int row2);
+static void table_top_k_sift_down(const table_sort_keys *keys, int *heap, int length, int index);
+static void table_sort_remember(table *t, const table_sort_spec *spec);
+static int table_sort_track_compare(const table *t, int row1, int row2);
+static bool table_sort_track_in_order(const table *t, int row);
+static void table_sort_track_check(table *t);
+static void table_argsort_spec(const table *t, table_sort_spec *spec, int num_rows, int num_threads);
+static void table_sort_keys_init(const table *t, table_sort_spec *spec, table_sort_key *keys, int num_rows);
+static void table_argsort_keys(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length);
+static void table_argsort_parallel(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length, int num_threads);
+static void *table_sort_task_sort(void *data);
+static void *table_sort_task_merge(void *data);
+static void table_sort_tasks_run(table_sort_task *tasks, int length, void *(*run)(void*));
+static int table_argsort_corank(const table_sort_keys *keys, const int *src, int first, int middle, int last, int diagonal);
+static bool table_radix_sortable(const table_sort_key *key);
+static uint64_t table_radix_key(table_data_type type, const void *value);
+static void table_radix_sort(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length);
+static void table_radix_sort_pass(int **src, int **dst, uint64_t **src_keys, uint64_t **dst_keys, int shift, int length);
+static void table_argsort_valid(const table_sort_keys *keys, int *rows, int *scratch, int length);
+static void table_argsort_strings(const table_sort_keys *keys, int *rows, int *scratch, int length);
+static void table_argsort_range(const table_sort_keys *keys, int *rows, int *scratch, int length);
+static void table_argsort_insertion(const table_sort_keys *keys, int *rows, int length);
+static void table_argsort_merge(const table_sort_keys *keys, const int *run1, int length1, const int *run2, int length2, int *dst);
 
 /**
  * \brief Multi-column sort
@@ -28,147 +128,1453 @@ static void table_merge_sort_copy_rows(table *t, int first, int last, table_row
  * \param[in] cols Array of indices of the columns to be sorted
  * \param[in] sort_orders Array of sort orders for each column
  * \param[in] num_cols Number of columns to be sorted
- * \return
+ *
+ * The sort is stable. Rows are ordered by the first column, rows that are
+ * equal on it by the second, and so on.
  */
 void table_column_sort(table *t, int *cols, table_order *sort_orders, int num_cols)
 {
-   int sort_column;
-   for (sort_column = 0; sort_column < num_cols; sort_column++)
+   table_sort_spec spec;
+
+   table_sort_spec_init(&spec, cols, sort_orders, num_cols);
+   table_sort(t, &spec);
+   table_sort_spec_destroy(&spec);
+}
+
+/**
+ * \brief Multi-column sort using several threads
+ * \param[in] table The table to be sorted
+ * \param[in] cols Array of indices of the columns to be sorted
+ * \param[in] sort_orders Array of sort orders for each column
+ * \param[in] num_cols Number of columns to be sorted
+ * \param[in] num_threads The largest number of threads to sort with
+ *
+ * The rows end up in exactly the same order as with table_column_sort().
+ */
+void table_column_sort_parallel(table *t, int *cols, table_order *sort_orders, int num_cols, int num_threads)
+{
+   table_sort_spec spec;
+
+   table_sort_spec_init(&spec, cols, sort_orders, num_cols);
+   table_sort_parallel(t, &spec, num_threads);
+   table_sort_spec_destroy(&spec);
+}
+
+/**
+ * \brief Initialize a sort specification
+ * \param[out] spec The sort specification
+ * \param[in] cols Array of indices of the columns to sort by, most significant first
+ * \param[in] orders Array of sort orders for each column
+ * \param[in] length Number of columns
+ * \return 0 on success, or -1 if the number of columns is negative
+ */
+int table_sort_spec_init(table_sort_spec *spec, const int *cols, const table_order *orders, int length)
+{
+   if (length < 0)
+      return -1;
+
+   spec->cols = NULL;
+   spec->orders = NULL;
+   spec->length = length;
+   spec->rows = NULL;
+   spec->scratch = NULL;
+   spec->allocated = 0;
+
+   if (length)
+   {
+      spec->cols = malloc(length * sizeof(int));
+      spec->orders = malloc(length * sizeof(table_order));
+      memcpy(spec->cols, cols, length * sizeof(int));
+      memcpy(spec->orders, orders, length * sizeof(table_order));
+   }
+
+   return 0;
+}
+
+/**
+ * \brief Destroy a sort specification
+ * \param[out] spec The sort specification
+ */
+void table_sort_spec_destroy(table_sort_spec *spec)
+{
+   free(spec->cols);
+   free(spec->orders);
+   free(spec->rows);
+   free(spec->scratch);
+
+   spec->cols = NULL;
+   spec->orders = NULL;
+   spec->rows = NULL;
+   spec->scratch = NULL;
+   spec->length = 0;
+   spec->allocated = 0;
+}
+
+/**
+ * \brief Sort the table by a sort specification
+ * \param[in] t The table to be sorted
+ * \param[in] spec The sort specification
+ *
+ * The sort is stable and makes a single pass, comparing rows on every
+ * column of the specification in turn until they differ.
+ */
+void table_sort(table *t, table_sort_spec *spec)
+{
+   table_sort_parallel(t, spec, 1);
+}
+
+/**
+ * \brief Sort the table by a sort specification using several threads
+ * \param[in] t The table to be sorted
+ * \param[in] spec The sort specification
+ * \param[in] num_threads The largest number of threads to sort with
+ *
+ * Each thread sorts a share of the rows, then the sorted runs are merged
+ * pairwise, every merge split among the threads. The rows end up in exactly
+ * the same order as with table_sort(). Comparators must be safe to call from
+ * several threads at once. Without thread support the table is sorted by the
+ * calling thread alone.
+ */
+void table_sort_parallel(table *t, table_sort_spec *spec, int num_threads)
+{
+   int num_rows = table_get_row_length(t);
+
+   if (num_rows < 2 || spec->length < 1)
+   {
+      table_sort_remember(t, spec);
+      table_notify(t, -1, -1, TABLE_SORTED);
+      return;
+   }
+
+   table_argsort_spec(t, spec, num_rows, num_threads);
+   table_sort_apply(t, spec, spec->rows);
+}
+
+/**
+ * \brief Move the rows of a table into a sort order
+ * \param[in] t The table to be sorted
+ * \param[in] spec The sort specification the order was found by
+ * \param[in] order An array of a row for every table row, the rows in sort order
+ */
+void table_sort_apply(table *t, const table_sort_spec *spec, const int *order)
+{
+   table_permute_rows(t, 0, order, table_get_row_length(t));
+
+   table_sort_remember(t, spec);
+   table_notify(t, -1, -1, TABLE_SORTED);
+}
+
+/**
+ * \brief Find the order of the rows in a sort, without sorting the table
+ * \param[in] t The table
+ * \param[in] spec The sort specification
+ * \param[out] perm An array of a row for every table row, set to the rows in sort order
+ * \return The number of rows
+ *
+ * perm is the order table_sort() would put the rows in, row indices and
+ * everything that refers to them stay valid.
+ */
+int table_argsort(const table *t, table_sort_spec *spec, int *perm)
+{
+   int num_rows = table_get_row_length(t);
+
+   if (num_rows < 2 || spec->length < 1)
+   {
+      for (int row = 0; row < num_rows; row++)
+         perm[row] = row;
+      return num_rows;
+   }
+
+   table_argsort_spec(t, spec, num_rows, 1);
+   memcpy(perm, spec->rows, num_rows * sizeof(int));
+
+   return num_rows;
+}
+
+/**
+ * \brief Create the sort keys of a sort specification
+ * \param[in] t The table to be sorted
+ * \param[in] spec The sort specification, with at least one column
+ * \return The sort context, or NULL on failure
+ *
+ * The context compares the rows of the table as they are when it is
+ * created, it must be destroyed before the table changes.
+ */
+table_sort_context *table_sort_context_create(const table *t, const table_sort_spec *spec)
+{
+   table_sort_context *context = malloc(sizeof(table_sort_context));
+
+   if (!context)
+      return NULL;
+
+   context->keys = malloc(spec->length * sizeof(table_sort_key));
+   if (!context->keys)
+   {
+      free(context);
+      return NULL;
+   }
+
+   for (int sort_column = 0; sort_column < spec->length; sort_column++)
+      table_sort_key_init(&context->keys[sort_column], t, spec->cols[sort_column], spec->orders[sort_column]);
+
+   context->sort_keys.keys = context->keys;
+   context->sort_keys.length = spec->length;
+   context->sort_keys.first_valid = false;
+
+   return context;
+}
+
+/**
+ * \brief Destroy a sort context
+ * \param[out] context The sort context
+ */
+void table_sort_context_destroy(table_sort_context *context)
+{
+   if (!context)
+      return;
+
+   free(context->keys);
+   free(context);
+}
+
+/**
+ * \brief Sort row indices in the order of a sort context
+ * \param[in] context The sort context
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ *
+ * The memory used besides rows and scratch depends on length only.
+ */
+void table_sort_context_argsort(const table_sort_context *context, int *rows, int *scratch, int length)
+{
+   table_argsort_keys(context->keys, context->sort_keys.length, rows, scratch, length);
+}
+
+/**
+ * \brief Compare two rows in the order of a sort context
+ * \param[in] context The sort context
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than, equal to or greater than zero if row1 sorts before, with or after row2
+ */
+int table_sort_context_compare(const table_sort_context *context, int row1, int row2)
+{
+   return table_sort_compare(&context->sort_keys, row1, row2);
+}
+
+/**
+ * \brief Sort the rows of a table into the row buffer of a sort specification
+ * \param[in] t The table
+ * \param[in,out] spec The sort specification
+ * \param[in] num_rows The number of rows of the table, at least two
+ * \param[in] num_threads The largest number of threads to sort with
+ */
+static void table_argsort_spec(const table *t, table_sort_spec *spec, int num_rows, int num_threads)
+{
+   table_sort_key *keys = malloc(spec->length * sizeof(table_sort_key));
+
+   table_sort_keys_init(t, spec, keys, num_rows);
+
+#ifdef TABLE_THREADS
+   if (num_threads > num_rows / PARALLEL_SORT_CUTOFF)
+      num_threads = num_rows / PARALLEL_SORT_CUTOFF;
+#else
+   num_threads = 1;
+#endif
+
+   if (num_threads > 1)
+      table_argsort_parallel(keys, spec->length, spec->rows, spec->scratch, num_rows, num_threads);
+   else
+      table_argsort_keys(keys, spec->length, spec->rows, spec->scratch, num_rows);
+
+   free(keys);
+}
+
+/**
+ * \brief Find the first rows of the table in a multi-column sort order
+ * \param[in] t The table
+ * \param[in] cols Array of indices of the columns to sort by, most significant first
+ * \param[in] orders Array of sort orders for each column
+ * \param[in] num_cols Number of columns
+ * \param[in] k The number of rows to find
+ * \param[out] rows An array of at least k rows, set to the rows found in sort order
+ * \return The number of rows found, the smaller of k and the number of rows
+ *
+ * The rows found are those table_column_sort() would move to the top, in the
+ * same order, but the table is left as it is. A heap of k rows is kept while
+ * scanning the table, taking O(n log k) time and no memory beyond rows.
+ */
+int table_top_k(const table *t, const int *cols, const table_order *orders, int num_cols, int k, int *rows)
+{
+   int num_rows = table_get_row_length(t);
+   table_sort_key *keys;
+   table_sort_keys sort_keys;
+   int length = 0, row;
+
+   if (k > num_rows)
+      k = num_rows;
+
+   if (k <= 0)
+      return 0;
+
+   keys = malloc((num_cols ? num_cols : 1) * sizeof(table_sort_key));
+   for (int sort_column = 0; sort_column < num_cols; sort_column++)
+      table_sort_key_init(&keys[sort_column], t, cols[sort_column], orders[sort_column]);
+
+   sort_keys.keys = keys;
+   sort_keys.length = num_cols;
+   sort_keys.first_valid = false;
+
+   /* The heap keeps the row that sorts last on top */
+   for (row = 0; row < num_rows; row++)
    {
-      int num_rows = table_get_row_length(t);
-      if (!sort_column)
+      if (length < k)
       {
-         table_merge_sort_rows(t, cols[sort_column], 0, num_rows-1, sort_orders[sort_column]);
+         int index = length++;
+         while (index && table_top_k_compare(&sort_keys, rows[(index - 1) / 2], row) < 0)
+         {
+            rows[index] = rows[(index - 1) / 2];
+            index = (index - 1) / 2;
+         }
+         rows[index] = row;
       }
-      else
+      else if (table_top_k_compare(&sort_keys, row, rows[0]) < 0)
       {
-         int row, first = -1, last = -1;
-	 table_comparator compare = table_get_column_comparator(t, cols[sort_column - 1]);
-         for (row = 0; row < num_rows; row++)
+         rows[0] = row;
+         table_top_k_sift_down(&sort_keys, rows, length, 0);
+      }
+   }
+
+   for (int last = length - 1; last > 0; last--)
+   {
+      int top = rows[0];
+      rows[0] = rows[last];
+      rows[last] = top;
+      table_top_k_sift_down(&sort_keys, rows, last, 0);
+   }
+
+   free(keys);
+
+   return length;
+}
+
+/**
+ * \brief Sort the first rows of the table by multiple columns
+ * \param[in] t The table to be sorted
+ * \param[in] cols Array of indices of the columns to sort by, most significant first
+ * \param[in] orders Array of sort orders for each column
+ * \param[in] num_cols Number of columns
+ * \param[in] k The number of rows to sort
+ * \return The number of rows sorted, the smaller of k and the number of rows
+ *
+ * The first k rows become those table_column_sort() would put there, found
+ * by table_top_k(). The rows they replace follow in the order they were in.
+ */
+int table_partial_sort(table *t, const int *cols, const table_order *orders, int num_cols, int k)
+{
+   int num_rows = table_get_row_length(t);
+   int *order;
+   bool *taken;
+   int length, row, next;
+
+   if (k >= num_rows)
+   {
+      table_sort_spec spec;
+
+      table_sort_spec_init(&spec, cols, orders, num_cols);
+      table_sort(t, &spec);
+      table_sort_spec_destroy(&spec);
+      return num_rows;
+   }
+
+   order = malloc(num_rows * sizeof(int));
+   length = table_top_k(t, cols, orders, num_cols, k, order);
+   if (!length)
+   {
+      free(order);
+      return 0;
+   }
+
+   taken = calloc(num_rows, sizeof(bool));
+   for (row = 0; row < length; row++)
+      taken[order[row]] = true;
+
+   for (row = 0, next = length; row < num_rows; row++)
+      if (!taken[row])
+         order[next++] = row;
+
+   table_permute_rows(t, 0, order, num_rows);
+
+   free(taken);
+   free(order);
+
+   t->sorted = false;
+   t->sort_unchecked = -1;
+   table_notify(t, -1, -1, TABLE_SORTED);
+
+   return length;
+}
+
+/**
+ * \brief Compare two rows for a top k search
+ * \param[in] keys The sort keys
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than or greater than zero if row1 sorts before or after row2
+ *
+ * Rows that are equal on every key are told apart by their index, as a
+ * stable sort would.
+ */
+static inline int table_top_k_compare(const table_sort_keys *keys, int row1, int row2)
+{
+   int result = table_sort_compare(keys, row1, row2);
+
+   if (result)
+      return result;
+
+   return (row1 > row2) - (row1 < row2);
+}
+
+/**
+ * \brief Restore the heap order below an index of a top k heap
+ * \param[in] keys The sort keys
+ * \param[in,out] heap The heap of rows, the row sorting last on top
+ * \param[in] length The number of rows in the heap
+ * \param[in] index The index of the row that may sort before its children
+ */
+static void table_top_k_sift_down(const table_sort_keys *keys, int *heap, int length, int index)
+{
+   int row = heap[index];
+
+   for (;;)
+   {
+      int child = 2 * index + 1;
+
+      if (child >= length)
+         break;
+
+      if (child + 1 < length && table_top_k_compare(keys, heap[child + 1], heap[child]) > 0)
+         child++;
+
+      if (table_top_k_compare(keys, heap[child], row) <= 0)
+         break;
+
+      heap[index] = heap[child];
+      index = child;
+   }
+
+   heap[index] = row;
+}
+
+/**
+ * \brief Get the sort specification the rows were last sorted by
+ * \param[in] t The table
+ * \return The sort specification, with no columns if the table was never sorted
+ */
+const table_sort_spec *table_get_sort_spec(const table *t)
+{
+   return &t->sort;
+}
+
+/**
+ * \brief Determine if the rows are still in the order they were last sorted in
+ * \param[in] t The table
+ * \return TRUE or FALSE
+ *
+ * Adding or setting a single row keeps the table sorted when the row is in
+ * order with its neighbours, removing rows does unless they are left as
+ * tombstones, which have no values until compaction. Bulk changes to the
+ * sort columns and changes to their comparators do not. The row added last
+ * is only checked when the order is needed or the table changes elsewhere,
+ * so that it can be given its values first.
+ */
+bool table_is_sorted(const table *t)
+{
+   return t->sorted && (t->sort_unchecked < 0 || table_sort_track_in_order(t, t->sort_unchecked));
+}
+
+/**
+ * \brief Sort the rows again by the sort specification they were last sorted by, if they are out of order
+ * \param[in] t The table
+ * \return 0 on success, or -1 if the table was never sorted
+ */
+int table_resort(table *t)
+{
+   if (!t->sort.length)
+      return -1;
+
+   if (!table_is_sorted(t))
+      table_sort(t, &t->sort);
+
+   return 0;
+}
+
+/**
+ * \brief Set whether lookups re-sort rows that are out of order first
+ * \param[out] t The table
+ * \param[in] sort_on_find Whether table_sorted_lookup() and table_sorted_lookup_equal_range() call table_resort() first
+ *
+ * This lets a batch of lookups follow any number of changes without sorting
+ * the table defensively. The rows found are those of the re-sorted table.
+ * Binary searches taking a const table never re-sort it.
+ */
+void table_set_sort_on_find(table *t, bool sort_on_find)
+{
+   t->sort_on_find = sort_on_find;
+}
+
+/**
+ * \brief Get whether lookups re-sort rows that are out of order first
+ * \param[in] t The table
+ * \return TRUE or FALSE
+ */
+bool table_get_sort_on_find(const table *t)
+{
+   return t->sort_on_find;
+}
+
+/**
+ * \brief Keep track of whether the rows are still sorted
+ * \param[out] t The table
+ * \param[in] row_index The row of the event, or -1 for every row
+ * \param[in] column_index The column of the event, or -1 for every column
+ * \param[in] event_type The event
+ */
+void table_sort_track(table *t, int row_index, int column_index, table_event_type event_type)
+{
+   int sort_column;
+
+   if (!t->sort.length)
+      return;
+
+   switch (event_type)
+   {
+      case TABLE_ROW_ADDED:
+         table_sort_track_check(t);
+         if (row_index < 0)
+            t->sorted = false;
+         else
+            t->sort_unchecked = row_index;
+         break;
+      case TABLE_ROW_REMOVED:
+         /* A tombstoned row keeps its place without a value until compaction */
+         if (row_index >= 0 && row_index < table_get_row_length(t) && table_row_is_removed(t, row_index))
          {
-            if (row)
-            {
-               int prior_column;
-               bool equal = false;
-               for (prior_column = sort_column - 1; prior_column >= 0; prior_column--)
-               {
-                  equal = !compare(table_get(t, row, cols[prior_column]), table_get(t, row - 1, cols[prior_column]));
-                  if (!equal)
-                     break;
-               }
-               if (equal)
-               {
-                  if (first == -1)
-                     first = row - 1;
-                  last = row;
-               }
-            }
-            if (first != -1 && (last != row || last == num_rows - 1))
+            t->sorted = false;
+            t->sort_unchecked = -1;
+            break;
+         }
+         if (t->sort_unchecked < 0 || row_index > t->sort_unchecked)
+            break;
+         if (row_index < 0)
+         {
+            /* Rows were removed in bulk, the row added last cannot be told apart any more */
+            if (table_get_row_length(t))
+               t->sorted = false;
+            t->sort_unchecked = -1;
+         }
+         else if (row_index == t->sort_unchecked)
+            t->sort_unchecked = -1;
+         else
+            t->sort_unchecked--;
+         break;
+      case TABLE_DATA_MODIFIED:
+         for (sort_column = 0; sort_column < t->sort.length; sort_column++)
+            if (column_index < 0 || t->sort.cols[sort_column] == column_index)
+               break;
+         if (sort_column == t->sort.length || (row_index >= 0 && row_index == t->sort_unchecked))
+            break;
+         if (row_index < 0)
+         {
+            t->sorted = false;
+            t->sort_unchecked = -1;
+         }
+         else if (t->sorted && !table_sort_track_in_order(t, row_index))
+            t->sorted = false;
+         break;
+      case TABLE_COLUMN_REMOVED:
+         for (sort_column = 0; sort_column < t->sort.length; sort_column++)
+         {
+            if (t->sort.cols[sort_column] == column_index)
             {
-               table_merge_sort_rows(t, cols[sort_column], first, last, sort_orders[sort_column]);
-               first = -1;
-               last = -1;
+               t->sort.length = 0;
+               t->sorted = false;
+               t->sort_unchecked = -1;
+               break;
             }
+            if (t->sort.cols[sort_column] > column_index)
+               t->sort.cols[sort_column]--;
          }
-      }
+         break;
+      default:
+         break;
    }
-   table_notify(t, -1, -1, TABLE_SORTED);
 }
 
 /**
- * \brief Row merge sort main function
- * \author Derrick Menn
+ * \brief Remember the sort specification the rows were sorted by
+ * \param[out] t The table
+ * \param[in] spec The sort specification
+ */
+static void table_sort_remember(table *t, const table_sort_spec *spec)
+{
+   if (spec != &t->sort && spec->length)
+   {
+      t->sort.cols = realloc(t->sort.cols, spec->length * sizeof(int));
+      t->sort.orders = realloc(t->sort.orders, spec->length * sizeof(table_order));
+      memcpy(t->sort.cols, spec->cols, spec->length * sizeof(int));
+      memcpy(t->sort.orders, spec->orders, spec->length * sizeof(table_order));
+   }
+
+   t->sort.length = spec->length;
+
+   t->sorted = spec->length > 0;
+   t->sort_unchecked = -1;
+}
+
+/**
+ * \brief Compare two rows in the order the rows were last sorted in
+ * \param[in] t The table
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row, which may be a row just being added
+ * \return Less than, equal to or greater than zero if row1 sorts before, with or after row2
+ */
+static int table_sort_track_compare(const table *t, int row1, int row2)
+{
+   int result = 0;
+
+   for (int sort_column = 0; !result && sort_column < t->sort.length; sort_column++)
+   {
+      int col = t->sort.cols[sort_column];
+      table_comparator compare = table_get_column_comparator(t, col);
+
+      if (t->sort.orders[sort_column] == TABLE_ASCENDING)
+         result = compare(table_get(t, row1, col), table_get(t, row2, col));
+      else
+         result = compare(table_get(t, row2, col), table_get(t, row1, col));
+   }
+
+   return result;
+}
+
+/**
+ * \brief Determine if a row is in order with its neighbours
+ * \param[in] t The table
+ * \param[in] row The table row
+ * \return TRUE or FALSE
+ *
+ * The row added last is passed over unless it is the row checked.
+ */
+static bool table_sort_track_in_order(const table *t, int row)
+{
+   int previous = row - 1, next = row + 1;
+
+   if (previous == t->sort_unchecked)
+      previous--;
+
+   if (next == t->sort_unchecked)
+      next++;
+
+   if (previous >= 0 && table_sort_track_compare(t, previous, row) > 0)
+      return false;
+
+   if (next < table_get_row_length(t) && table_sort_track_compare(t, row, next) > 0)
+      return false;
+
+   return true;
+}
+
+/**
+ * \brief Check the row added last against its neighbours
+ * \param[out] t The table
+ */
+static void table_sort_track_check(table *t)
+{
+   if (t->sort_unchecked < 0)
+      return;
+
+   if (t->sorted && !table_sort_track_in_order(t, t->sort_unchecked))
+      t->sorted = false;
+
+   t->sort_unchecked = -1;
+}
+
+/**
+ * \brief Prepare the sort keys and buffers of a sort specification
  * \param[in] t The table to be sorted
- * \param[in] col The column to sort by
- * \param[in] first The first row to sort
- * \param[in] last The last row to sort
- * \param[in] order The table_order to sort the rows by
+ * \param[in,out] spec The sort specification
+ * \param[out] keys The sort keys, one for each column of the specification
+ * \param[in] num_rows The number of rows of the table
  */
-static void table_merge_sort_rows(table *t, int col, int first, int last, table_order order)
+static void table_sort_keys_init(const table *t, table_sort_spec *spec, table_sort_key *keys, int num_rows)
 {
-   table_row *sorted_rows = calloc(last - first + 1, sizeof(table_row));
-   table_merge_sort_split_rows(t, sorted_rows, col, first, last, order);
-   free(sorted_rows);
+   int sort_column, row;
+
+   if (spec->allocated < (size_t)num_rows)
+   {
+      spec->rows = realloc(spec->rows, num_rows * sizeof(int));
+      spec->scratch = realloc(spec->scratch, num_rows * sizeof(int));
+      spec->allocated = num_rows;
+   }
+
+   for (sort_column = 0; sort_column < spec->length; sort_column++)
+      table_sort_key_init(&keys[sort_column], t, spec->cols[sort_column], spec->orders[sort_column]);
+
+   for (row = 0; row < num_rows; row++)
+      spec->rows[row] = row;
 }
 
 /**
- * \brief Row merge sort split row list into row sublist function
- * \author Derrick Menn
+ * \brief Initialize a sort key
+ * \param[out] key The sort key
  * \param[in] t The table to be sorted
- * \param[in] sorted_rows Array to hold the sorted rows
- * \param[in] col The column to sort the table rows by
- * \param[in] first The first row to start sorting at
- * \param[in] last The last row to sort
- * \param[in] order The table_order to sort by
+ * \param[in] col The column to sort by
+ * \param[in] order The order to sort the column in
  */
-static void table_merge_sort_split_rows(table *t, table_row *sorted_rows, int col, int first, int last, table_order order)
+static void table_sort_key_init(table_sort_key *key, const table *t, int col, table_order order)
 {
-   if (last - first + 1 < 2)
-      return;
-   int middle = (first + last)/2;
-   table_merge_sort_split_rows(t, sorted_rows, col, first, middle, order);
-   table_merge_sort_split_rows(t, sorted_rows, col, middle + 1, last, order);
-   table_merge_sort_merge_rows(t, sorted_rows, col, first, middle, last, order);
-   table_merge_sort_copy_rows(t, first, last, sorted_rows);
+   table_column *column = table_get_col_ptr(t, col);
+
+   key->t = t;
+   key->col = col;
+   key->order = order;
+   key->compare = column->comparator;
+   key->default_comparator = column->comparator == table_get_default_comparator_for_data_type(column->type);
+   table_storage_get_view(t, col, &key->view);
+}
+
+/**
+ * \brief Get the value of a row being sorted
+ * \param[in] key The sort key
+ * \param[in] row The table row
+ * \return The value pointer, rows with a default comparator must have a value
+ */
+static inline void *table_sort_get(const table_sort_key *key, int row)
+{
+   if (!key->default_comparator)
+      return table_get(key->t, row, key->col);
+
+   if (key->view.base)
+      return TABLE_VIEW_VALUE(&key->view, row);
+
+   return table_storage_get_value(key->t, row, key->col);
+}
+
+/**
+ * \brief Compare two rows in the order of a sort key
+ * \param[in] key The sort key
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than, equal to or greater than zero if row1 sorts before, with or after row2
+ *
+ * Rows with a default comparator must have a value.
+ */
+static inline int table_sort_compare_values(const table_sort_key *key, int row1, int row2)
+{
+   if (key->order == TABLE_ASCENDING)
+      return key->compare(table_sort_get(key, row1), table_sort_get(key, row2));
+
+   return key->compare(table_sort_get(key, row2), table_sort_get(key, row1));
+}
+
+/**
+ * \brief Compare two rows in the order of a sort key, with or without values
+ * \param[in] key The sort key
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than, equal to or greater than zero if row1 sorts before, with or after row2
+ */
+static inline int table_sort_compare_rows(const table_sort_key *key, int row1, int row2)
+{
+   if (key->default_comparator && key->view.null_count)
+   {
+      int valid1 = TABLE_BITMAP_GET(key->view.validity, row1);
+      int valid2 = TABLE_BITMAP_GET(key->view.validity, row2);
+
+      if (!valid1 || !valid2)
+         return key->order == TABLE_ASCENDING ? valid1 - valid2 : valid2 - valid1;
+   }
+
+   return table_sort_compare_values(key, row1, row2);
 }
 
 /**
- * \brief Row merge sort merge row sublists function
+ * \brief Compare two rows on every sort key
+ * \param[in] keys The sort keys
+ * \param[in] row1 The first table row
+ * \param[in] row2 The second table row
+ * \return Less than, equal to or greater than zero if row1 sorts before, with or after row2
+ */
+static inline int table_sort_compare(const table_sort_keys *keys, int row1, int row2)
+{
+   int result;
+
+   if (keys->first_valid)
+      result = table_sort_compare_values(&keys->keys[0], row1, row2);
+   else
+      result = table_sort_compare_rows(&keys->keys[0], row1, row2);
+
+   for (int key = 1; !result && key < keys->length; key++)
+      result = table_sort_compare_rows(&keys->keys[key], row1, row2);
+
+   return result;
+}
+
+/**
+ * \brief Sort row indices by a list of sort keys
  * \author Derrick Menn
- * \param[in] t The table to sort by
- * \param[in] sorted_rows Array to hold the sorted rows
- * \param[in] col The column to sort table rows by
- * \param[in] first The index of the first row in the sublist
- * \param[in] middle The index of the middle row in the sublist
- * \param[in] last The index of the last row in the sublist
- * \param[in] order The table_order to sort by
+ * \param[in] keys The sort keys, most significant first
+ * \param[in] num_keys The number of sort keys
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ *
+ * When the first column uses its default comparator, the rows without a
+ * value are set aside first, where the comparator would have placed them.
+ * The remaining rows are sorted without checking their validity on the
+ * first column, the rows set aside are sorted by the other columns.
  */
-static void table_merge_sort_merge_rows(table *t, table_row *sorted_rows, int col, int first, int middle, int last, table_order order)
+static void table_argsort_keys(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length)
 {
-   int n1 = first, n2 = middle + 1, i;
-   table_comparator compare = table_get_column_comparator(t, col);
-   for (i = 0; i < last - first + 1; i++)
+   table_sort_keys valid_keys = { keys, num_keys, keys[0].default_comparator };
+   table_sort_keys null_keys = { keys + 1, num_keys - 1, false };
+   int valid = 0, nulls = 0, i;
+   int *valid_rows = rows, *null_rows;
+
+   if (length < 2)
+      return;
+
+   if (length >= RADIX_SORT_CUTOFF)
    {
-      if (order == TABLE_ASCENDING)
+      for (i = 0; i < num_keys && table_radix_sortable(&keys[i]); i++)
+         ;
+
+      if (i == num_keys)
       {
-         if (n1 <= middle && (n2 > last || compare(table_get(t, n1, col), table_get(t, n2, col)) < 0))
+         table_radix_sort(keys, num_keys, rows, scratch, length);
+         return;
+      }
+   }
+
+   if (!keys[0].default_comparator || !keys[0].view.null_count)
+   {
+      table_argsort_valid(&valid_keys, rows, scratch, length);
+      return;
+   }
+
+   for (i = 0; i < length; i++)
+   {
+      if (TABLE_BITMAP_GET(keys[0].view.validity, rows[i]))
+         rows[valid++] = rows[i];
+      else
+         scratch[nulls++] = rows[i];
+   }
+
+   if (keys[0].order == TABLE_ASCENDING)
+   {
+      memmove(rows + nulls, rows, valid * sizeof(int));
+      memcpy(rows, scratch, nulls * sizeof(int));
+      null_rows = rows;
+      valid_rows = rows + nulls;
+   }
+   else
+   {
+      memcpy(rows + valid, scratch, nulls * sizeof(int));
+      null_rows = rows + valid;
+   }
+
+   table_argsort_valid(&valid_keys, valid_rows, scratch, valid);
+   if (null_keys.length)
+      table_argsort_range(&null_keys, null_rows, scratch, nulls);
+}
+
+/**
+ * \brief Determine if a sort key can be radix sorted
+ * \param[in] key The sort key
+ * \return TRUE or FALSE
+ */
+static bool table_radix_sortable(const table_sort_key *key)
+{
+   if (!key->default_comparator)
+      return false;
+
+   switch (key->view.type)
+   {
+      case TABLE_LDOUBLE:
+      case TABLE_STRING:
+      case TABLE_PTR:
+         return false;
+      default:
+         return true;
+   }
+}
+
+/**
+ * \brief Map a value to an unsigned key that orders like the value
+ * \param[in] type The data type of the value
+ * \param[in] value The value
+ * \return The radix key, using as many low bytes as the data type
+ *
+ * Signed values have their sign bit flipped. Negative floating point values
+ * have every bit flipped and positive ones their sign bit, with negative zero
+ * mapped to zero, as the comparators consider them equal.
+ */
+static uint64_t table_radix_key(table_data_type type, const void *value)
+{
+   switch (type)
+   {
+      case TABLE_INT:
+         return TABLE_RADIX_SIGNED(*(const int*)value);
+      case TABLE_UINT:
+         return *(const unsigned int*)value;
+      case TABLE_INT8:
+         return TABLE_RADIX_SIGNED(*(const int8_t*)value);
+      case TABLE_UINT8:
+         return *(const uint8_t*)value;
+      case TABLE_INT16:
+         return TABLE_RADIX_SIGNED(*(const int16_t*)value);
+      case TABLE_UINT16:
+         return *(const uint16_t*)value;
+      case TABLE_INT32:
+         return TABLE_RADIX_SIGNED(*(const int32_t*)value);
+      case TABLE_UINT32:
+         return *(const uint32_t*)value;
+      case TABLE_INT64:
+         return TABLE_RADIX_SIGNED(*(const int64_t*)value);
+      case TABLE_UINT64:
+         return *(const uint64_t*)value;
+      case TABLE_SHORT:
+         return TABLE_RADIX_SIGNED(*(const short*)value);
+      case TABLE_USHORT:
+         return *(const unsigned short*)value;
+      case TABLE_LONG:
+         return TABLE_RADIX_SIGNED(*(const long*)value);
+      case TABLE_ULONG:
+         return *(const unsigned long*)value;
+      case TABLE_LLONG:
+         return TABLE_RADIX_SIGNED(*(const long long*)value);
+      case TABLE_ULLONG:
+         return *(const unsigned long long*)value;
+      case TABLE_FLOAT:
          {
-            sorted_rows[i] = *table_get_row_ptr(t, n1);
-            n1++;
+            float f = *(const float*)value;
+            uint32_t bits;
+            if (f == 0.0f)
+               f = 0.0f;
+            memcpy(&bits, &f, sizeof(bits));
+            return bits & 0x80000000u ? ~bits : bits ^ 0x80000000u;
          }
-         else
+      case TABLE_DOUBLE:
          {
-            sorted_rows[i] = *table_get_row_ptr(t, n2);
-            n2++;
+            double d = *(const double*)value;
+            uint64_t bits;
+            if (d == 0.0)
+               d = 0.0;
+            memcpy(&bits, &d, sizeof(bits));
+            return bits & 0x8000000000000000u ? ~bits : bits ^ 0x8000000000000000u;
          }
+      case TABLE_CHAR:
+         if (CHAR_MIN < 0)
+            return TABLE_RADIX_SIGNED(*(const signed char*)value);
+         return *(const unsigned char*)value;
+      case TABLE_UCHAR:
+         return *(const unsigned char*)value;
+      case TABLE_BOOL:
+         return *(const bool*)value;
+      default:
+         return 0;
+   }
+}
+
+/**
+ * \brief Least significant digit radix sort of row indices
+ * \param[in] keys The sort keys, most significant first, all radix sortable
+ * \param[in] num_keys The number of sort keys
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ *
+ * Every pass is a stable counting sort, so sorting by the least significant
+ * byte of the last key first and the most significant byte of the first key
+ * last orders the rows on every key. Descending keys are complemented. A
+ * key with rows without a value gets a final pass on its validity bit, which
+ * sets those rows aside where the comparator would have placed them. The
+ * radix keys move along with the rows, so the memory used depends on the
+ * number of rows sorted rather than on the size of the table.
+ */
+static void table_radix_sort(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length)
+{
+   uint64_t *radix_keys = malloc(2 * (size_t)length * sizeof(uint64_t));
+   uint64_t *src_keys = radix_keys, *dst_keys = radix_keys + length;
+   int *src = rows, *dst = scratch;
+
+   for (int key_index = num_keys - 1; key_index >= 0; key_index--)
+   {
+      const table_sort_key *key = &keys[key_index];
+      size_t size = table_get_data_type_size(key->view.type);
+      uint64_t mask = TABLE_RADIX_MASK(size);
+      int i;
+
+      for (i = 0; i < length; i++)
+      {
+         int row = src[i];
+         uint64_t radix_key = 0;
+
+         if (!key->view.null_count || TABLE_BITMAP_GET(key->view.validity, row))
+            radix_key = table_radix_key(key->view.type, table_sort_get(key, row));
+
+         src_keys[i] = key->order == TABLE_ASCENDING ? radix_key : ~radix_key & mask;
       }
-      else
+
+      for (size_t byte = 0; byte < size; byte++)
+         table_radix_sort_pass(&src, &dst, &src_keys, &dst_keys, byte * 8, length);
+
+      if (key->view.null_count)
       {
-         if (n1 <= middle && (n2 > last || compare(table_get(t, n1, col), table_get(t, n2, col)) > 0))
+         /* Rows without a value sort first ascending, last descending */
+         for (i = 0; i < length; i++)
          {
-            sorted_rows[i] = *table_get_row_ptr(t, n1);
-            n1++;
+            int valid = TABLE_BITMAP_GET(key->view.validity, src[i]);
+            src_keys[i] = key->order == TABLE_ASCENDING ? valid : !valid;
          }
-         else
+
+         table_radix_sort_pass(&src, &dst, &src_keys, &dst_keys, 0, length);
+      }
+   }
+
+   if (src != rows)
+      memcpy(rows, src, length * sizeof(int));
+
+   free(radix_keys);
+}
+
+/**
+ * \brief Distribute row indices and their radix keys by one byte of the keys
+ * \param[in,out] src The row indices to distribute, swapped with dst when they move
+ * \param[in,out] dst The row indices to distribute into
+ * \param[in,out] src_keys The radix key of each row index, swapped with dst_keys when they move
+ * \param[in,out] dst_keys The radix keys to distribute into
+ * \param[in] shift The bit offset of the byte
+ * \param[in] length The number of row indices
+ *
+ * Nothing is moved when every row has the same byte.
+ */
+static void table_radix_sort_pass(int **src, int **dst, uint64_t **src_keys, uint64_t **dst_keys, int shift, int length)
+{
+   const uint64_t *keys = *src_keys;
+   const int *rows = *src;
+   int counts[256] = { 0 };
+   int offset = 0, i;
+   int *swap;
+   uint64_t *swap_keys;
+
+   for (i = 0; i < length; i++)
+      counts[(keys[i] >> shift) & 0xFF]++;
+
+   if (counts[(keys[0] >> shift) & 0xFF] == length)
+      return;
+
+   for (i = 0; i < 256; i++)
+   {
+      int count = counts[i];
+      counts[i] = offset;
+      offset += count;
+   }
+
+   for (i = 0; i < length; i++)
+   {
+      int position = counts[(keys[i] >> shift) & 0xFF]++;
+      (*dst)[position] = rows[i];
+      (*dst_keys)[position] = keys[i];
+   }
+
+   swap = *src;
+   *src = *dst;
+   *dst = swap;
+   swap_keys = *src_keys;
+   *src_keys = *dst_keys;
+   *dst_keys = swap_keys;
+}
+
+/*
+ * Define the merge sort of row indices with a given row comparison, as
+ * table_argsort_range##suffix, a bottom-up merge sort of rows using a
+ * single scratch buffer of at least length row indices. Runs of
+ * INSERTION_SORT_CUTOFF rows are insertion sorted by
+ * table_argsort_insertion##suffix first, then merged pairwise by
+ * table_argsort_merge##suffix, which takes the rows of the first run first
+ * when equal, keeping the sort stable.
+ */
+#define TABLE_ARGSORT_DEFINE(suffix, compare)                                                                   \
+static void table_argsort_insertion##suffix(const table_sort_keys *keys, int *rows, int length)                 \
+{                                                                                                               \
+   for (int i = 1; i < length; i++)                                                                             \
+   {                                                                                                            \
+      int row = rows[i], j;                                                                                     \
+      for (j = i; j > 0 && compare(keys, rows[j - 1], row) > 0; j--)                                            \
+         rows[j] = rows[j - 1];                                                                                 \
+      rows[j] = row;                                                                                            \
+   }                                                                                                            \
+}                                                                                                               \
+                                                                                                                \
+static void table_argsort_merge##suffix(const table_sort_keys *keys, const int *run1, int length1,              \
+                                        const int *run2, int length2, int *dst)                                 \
+{                                                                                                               \
+   int n1 = 0, n2 = 0, i = 0;                                                                                   \
+                                                                                                                \
+   while (n1 < length1 && n2 < length2)                                                                         \
+   {                                                                                                            \
+      if (compare(keys, run1[n1], run2[n2]) <= 0)                                                               \
+         dst[i++] = run1[n1++];                                                                                 \
+      else                                                                                                      \
+         dst[i++] = run2[n2++];                                                                                 \
+   }                                                                                                            \
+                                                                                                                \
+   while (n1 < length1)                                                                                         \
+      dst[i++] = run1[n1++];                                                                                    \
+                                                                                                                \
+   while (n2 < length2)                                                                                         \
+      dst[i++] = run2[n2++];                                                                                    \
+}                                                                                                               \
+                                                                                                                \
+static void table_argsort_range##suffix(const table_sort_keys *keys, int *rows, int *scratch, int length)       \
+{                                                                                                               \
+   int *src = rows, *dst = scratch, *swap;                                                                      \
+   int width, first;                                                                                            \
+                                                                                                                \
+   for (first = 0; first < length; first += INSERTION_SORT_CUTOFF)                                              \
+      table_argsort_insertion##suffix(keys, rows + first,                                                       \
+         length - first < INSERTION_SORT_CUTOFF ? length - first : INSERTION_SORT_CUTOFF);                      \
+                                                                                                                \
+   for (width = INSERTION_SORT_CUTOFF; width < length; width *= 2)                                              \
+   {                                                                                                            \
+      for (first = 0; first < length; first += 2 * width)                                                       \
+      {                                                                                                         \
+         int middle = first + width < length ? first + width : length;                                          \
+         int last = first + 2 * width < length ? first + 2 * width : length;                                   \
+         table_argsort_merge##suffix(keys, src + first, middle - first,                                         \
+                                     src + middle, last - middle, dst + first);                                 \
+      }                                                                                                         \
+                                                                                                                \
+      swap = src;                                                                                               \
+      src = dst;                                                                                                \
+      dst = swap;                                                                                               \
+   }                                                                                                            \
+                                                                                                                \
+   if (src != rows)                                                                                             \
+      memcpy(rows, src, length * sizeof(int));                                                                  \
+}
+
+TABLE_ARGSORT_DEFINE(, table_sort_compare)
+
+/*
+ * Define the row comparisons and merge sorts for a first sort key using the
+ * default comparator of a data type, on rows known to have a value. The
+ * values of the first key are compared in place, the other keys as usual.
+ */
+#define TABLE_SORT_KERNEL(name, type, data_type, kind)                                                          \
+static inline int table_sort_compare_##name##_ascending(const table_sort_keys *keys, int row1, int row2)        \
+{                                                                                                               \
+   const table_sort_key *key = keys->keys;                                                                      \
+   type value1 = *(const type*)TABLE_KERNEL_SLOT(key->t, &key->view, row1, key->col);                          \
+   type value2 = *(const type*)TABLE_KERNEL_SLOT(key->t, &key->view, row2, key->col);                          \
+   int result = kind##_COMPARE(value1, value2);                                                                 \
+                                                                                                                \
+   for (int k = 1; !result && k < keys->length; k++)                                                            \
+      result = table_sort_compare_rows(&keys->keys[k], row1, row2);                                             \
+                                                                                                                \
+   return result;                                                                                               \
+}                                                                                                               \
+                                                                                                                \
+static inline int table_sort_compare_##name##_descending(const table_sort_keys *keys, int row1, int row2)       \
+{                                                                                                               \
+   const table_sort_key *key = keys->keys;                                                                      \
+   type value1 = *(const type*)TABLE_KERNEL_SLOT(key->t, &key->view, row1, key->col);                          \
+   type value2 = *(const type*)TABLE_KERNEL_SLOT(key->t, &key->view, row2, key->col);                          \
+   int result = kind##_COMPARE(value2, value1);                                                                 \
+                                                                                                                \
+   for (int k = 1; !result && k < keys->length; k++)                                                            \
+      result = table_sort_compare_rows(&keys->keys[k], row1, row2);                                             \
+                                                                                                                \
+   return result;                                                                                               \
+}                                                                                                               \
+                                                                                                                \
+TABLE_ARGSORT_DEFINE(_##name##_ascending, table_sort_compare_##name##_ascending)                                \
+TABLE_ARGSORT_DEFINE(_##name##_descending, table_sort_compare_##name##_descending)
+
+TABLE_KERNEL_TYPES(TABLE_SORT_KERNEL)
+
+/**
+ * \brief Sort row indices that have a value on the first sort key
+ * \param[in] keys The sort keys
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ *
+ * When the first key uses the default comparator of its data type, the
+ * merge sort specialised for the type and order is picked once. Strings are
+ * sorted by their prefixes first.
+ */
+static void table_argsort_valid(const table_sort_keys *keys, int *rows, int *scratch, int length)
+{
+   bool ascending = keys->keys[0].order == TABLE_ASCENDING;
+
+   if (keys->first_valid)
+   {
+      if (keys->keys[0].view.type == TABLE_STRING && length >= RADIX_SORT_CUTOFF)
+      {
+         table_argsort_strings(keys, rows, scratch, length);
+         return;
+      }
+
+      switch (keys->keys[0].view.type)
+      {
+#define TABLE_SORT_DISPATCH(name, type, data_type, kind)                              \
+         case data_type:                                                              \
+            if (ascending)                                                            \
+               table_argsort_range_##name##_ascending(keys, rows, scratch, length);   \
+            else                                                                      \
+               table_argsort_range_##name##_descending(keys, rows, scratch, length);  \
+            return;
+         TABLE_KERNEL_TYPES(TABLE_SORT_DISPATCH)
+#undef TABLE_SORT_DISPATCH
+         default:
+            break;
+      }
+   }
+
+   table_argsort_range(keys, rows, scratch, length);
+}
+
+/**
+ * \brief Sort row indices with a value on a first string key by the prefixes of the strings
+ * \param[in] keys The sort keys
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ *
+ * The rows are radix sorted by the first 8 bytes of their strings, read once
+ * per row or taken from the prefixes cached for binary searches. Only runs
+ * of rows with equal prefixes are then merge sorted on the whole strings and
+ * the other keys, unless the strings are known to be equal and there are no
+ * other keys.
+ */
+static void table_argsort_strings(const table_sort_keys *keys, int *rows, int *scratch, int length)
+{
+   const table_sort_key *key = keys->keys;
+   uint64_t *radix_keys = malloc(2 * (size_t)length * sizeof(uint64_t));
+   uint64_t *src_keys = radix_keys, *dst_keys = radix_keys + length;
+   const uint64_t *prefixes = table_storage_get_prefixes(key->t, key->col, false);
+   int *src = rows, *dst = scratch;
+   int first, last;
+
+   for (int i = 0; i < length; i++)
+   {
+      int row = rows[i];
+      uint64_t prefix = prefixes ? prefixes[row] : table_string_prefix(table_sort_get(key, row));
+      src_keys[i] = key->order == TABLE_ASCENDING ? prefix : ~prefix;
+   }
+
+   for (int shift = 0; shift < 64; shift += 8)
+      table_radix_sort_pass(&src, &dst, &src_keys, &dst_keys, shift, length);
+
+   if (src != rows)
+      memcpy(rows, src, length * sizeof(int));
+
+   for (first = 0; first < length; first = last)
+   {
+      uint64_t radix_key = src_keys[first];
+      uint64_t prefix = key->order == TABLE_ASCENDING ? radix_key : ~radix_key;
+
+      for (last = first + 1; last < length && src_keys[last] == radix_key; last++)
+         ;
+
+      if (last - first < 2 || (!(prefix & 0xFF) && keys->length == 1))
+         continue;
+
+      if (key->order == TABLE_ASCENDING)
+         table_argsort_range_string_ascending(keys, rows + first, scratch, last - first);
+      else
+         table_argsort_range_string_descending(keys, rows + first, scratch, last - first);
+   }
+
+   free(radix_keys);
+}
+
+/**
+ * \brief Sort row indices by a list of sort keys using several threads
+ * \param[in] keys The sort keys, most significant first
+ * \param[in] num_keys The number of sort keys
+ * \param[in,out] rows The row indices to sort
+ * \param[in] scratch A buffer of at least length row indices
+ * \param[in] length The number of row indices
+ * \param[in] num_threads The number of threads, at least two
+ */
+static void table_argsort_parallel(const table_sort_key *keys, int num_keys, int *rows, int *scratch, int length, int num_threads)
+{
+   table_sort_task *tasks = malloc(num_threads * sizeof(table_sort_task));
+   int *runs = malloc((num_threads + 1) * sizeof(int));
+   int *src = rows, *dst = scratch, *swap;
+   int num_runs = num_threads, i;
+
+   for (i = 0; i <= num_runs; i++)
+      runs[i] = (int)((long long)length * i / num_runs);
+
+   for (i = 0; i < num_runs; i++)
+   {
+      tasks[i].keys = keys;
+      tasks[i].num_keys = num_keys;
+      tasks[i].src = rows;
+      tasks[i].dst = scratch;
+      tasks[i].first = runs[i];
+      tasks[i].middle = runs[i + 1];
+      tasks[i].last = runs[i + 1];
+   }
+
+   table_sort_tasks_run(tasks, num_runs, table_sort_task_sort);
+
+   while (num_runs > 1)
+   {
+      int num_pairs = (num_runs + 1) / 2;
+      int shares = num_threads / num_pairs > 1 ? num_threads / num_pairs : 1;
+      int num_tasks = 0;
+
+      for (int pair = 0; pair < num_pairs; pair++)
+      {
+         int first = runs[2 * pair];
+         int middle = runs[2 * pair + 1];
+         int last = 2 * pair + 2 <= num_runs ? runs[2 * pair + 2] : middle;
+
+         for (int share = 0; share < shares; share++)
          {
-            sorted_rows[i] = *table_get_row_ptr(t, n2);
-            n2++;
+            table_sort_task *task = &tasks[num_tasks++];
+            task->keys = keys;
+            task->num_keys = num_keys;
+            task->src = src;
+            task->dst = dst;
+            task->first = first;
+            task->middle = middle;
+            task->last = last;
+            task->output_first = (int)((long long)(last - first) * share / shares);
+            task->output_last = (int)((long long)(last - first) * (share + 1) / shares);
          }
+
+         runs[pair] = first;
       }
+
+      runs[num_pairs] = length;
+      num_runs = num_pairs;
+
+      table_sort_tasks_run(tasks, num_tasks, table_sort_task_merge);
+
+      swap = src;
+      src = dst;
+      dst = swap;
    }
+
+   if (src != rows)
+      memcpy(rows, src, length * sizeof(int));
+
+   free(runs);
+   free(tasks);
 }
 
 /**
- * \brief Row merge sort copy sorted rows back into table
- * \author Derrick Menn
- * \param[in] t The table to be sorted
- * \param[in] first The index of the first row that was sorted
- * \param[in] last The index of the last row that was sorted
- * \param[in] sorted_rows Array of sorted rows
+ * \brief Sort the rows of a parallel sort task
+ * \param[in] data The task
+ * \return NULL
  */
-static void table_merge_sort_copy_rows(table *t, int first, int last, table_row *sorted_rows)
+static void *table_sort_task_sort(void *data)
 {
-   int i = 0;
-   for (i = 0; i < last - first + 1; i++)
-      table_set_row_ptr(t, first+i, &sorted_rows[i]);
+   table_sort_task *task = data;
+
+   table_argsort_keys(task->keys, task->num_keys, task->src + task->first, task->dst + task->first,
+                      task->last - task->first);
+   return NULL;
+}
+
+/**
+ * \brief Merge the share of two runs of a parallel sort task
+ * \param[in] data The task
+ * \return NULL
+ */
+static void *table_sort_task_merge(void *data)
+{
+   table_sort_task *task = data;
+   table_sort_keys keys = { task->keys, task->num_keys, false };
+   int first1 = table_argsort_corank(&keys, task->src, task->first, task->middle, task->last, task->output_first);
+   int last1 = table_argsort_corank(&keys, task->src, task->first, task->middle, task->last, task->output_last);
+   int first2 = task->output_first - first1, last2 = task->output_last - last1;
+
+   table_argsort_merge(&keys, task->src + task->first + first1, last1 - first1,
+                       task->src + task->middle + first2, last2 - first2, task->dst + task->first + task->output_first);
+   return NULL;
+}
+
+/**
+ * \brief Run parallel sort tasks, each on its own thread
+ * \param[in] tasks The tasks
+ * \param[in] length The number of tasks
+ * \param[in] run The function running a task
+ *
+ * The calling thread runs the first task, and any task no thread could be
+ * created for.
+ */
+static void table_sort_tasks_run(table_sort_task *tasks, int length, void *(*run)(void*))
+{
+#ifdef TABLE_THREADS
+   pthread_t *threads = malloc(length * sizeof(pthread_t));
+   bool *started = calloc(length, sizeof(bool));
+   int i;
+
+   for (i = 1; i < length; i++)
+      started[i] = !pthread_create(&threads[i], NULL, run, &tasks[i]);
+
+   run(&tasks[0]);
+
+   for (i = 1; i < length; i++)
+   {
+      if (started[i])
+         pthread_join(threads[i], NULL);
+      else
+         run(&tasks[i]);
+   }
+
+   free(started);
+   free(threads);
+#else
+   for (int i = 0; i < length; i++)
+      run(&tasks[i]);
+#endif
+}
+
+/**
+ * \brief Find how many rows of the first run precede a merged row
+ * \param[in] keys The sort keys
+ * \param[in] src The row indices holding both runs
+ * \param[in] first The index of the first row of the first run
+ * \param[in] middle The index of the first row of the second run
+ * \param[in] last The index past the last row of the second run
+ * \param[in] diagonal The index of the merged row, counted from first
+ * \return The number of rows of the first run merged before it
+ *
+ * Binary searches the split the merge of table_argsort_merge() would reach
+ * after taking diagonal rows, so that merges of consecutive shares join up.
+ */
+static int table_argsort_corank(const table_sort_keys *keys, const int *src, int first, int middle, int last, int diagonal)
+{
+   int low = diagonal > last - middle ? diagonal - (last - middle) : 0;
+   int high = diagonal < middle - first ? diagonal : middle - first;
+
+   while (low < high)
+   {
+      int i = low + (high - low) / 2;
+      if (table_sort_compare(keys, src[first + i], src[middle + diagonal - i - 1]) <= 0)
+         low = i + 1;
+      else
+         high = i;
+   }
+
+   return low;
 }
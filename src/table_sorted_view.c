@@ -0,0 +1,170 @@
+/**
+ * \file
+ * \brief The table sorted view implementation file
+ *
+ * This file handles sorted views. A sorted view keeps its own ordering of
+ * the rows of a table as a permutation, so that several consumers can each
+ * read one shared table in their own order without moving its rows.
+ */
+#include "table_defs.h"
+
+static int table_sorted_view_compare(const table_sorted_view *view, int col, table_order order, void *value, int index);
+
+/**
+ * \brief Initialize a sorted view of a table
+ * \param[out] view The sorted view
+ * \param[in] t The table
+ * \param[in] cols Array of indices of the columns to sort by, most significant first
+ * \param[in] orders Array of sort orders for each column
+ * \param[in] length Number of columns
+ * \return 0 on success, or -1 if the number of columns is negative or memory runs out
+ */
+int table_sorted_view_init(table_sorted_view *view, const table *t, const int *cols, const table_order *orders, int length)
+{
+  if (table_sort_spec_init(&view->spec, cols, orders, length))
+    return -1;
+
+  view->t = t;
+  view->rows = NULL;
+  view->length = 0;
+  view->allocated = 0;
+  if (table_sorted_view_refresh(view))
+  {
+    table_sorted_view_destroy(view);
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * \brief Destroy a sorted view
+ * \param[out] view The sorted view
+ */
+void table_sorted_view_destroy(table_sorted_view *view)
+{
+  table_sort_spec_destroy(&view->spec);
+  free(view->rows);
+  view->rows = NULL;
+  view->length = 0;
+  view->allocated = 0;
+}
+
+/**
+ * \brief Sort a view again, taking in every change to its table
+ * \param[out] view The sorted view
+ * \return 0 on success, or -1 on allocation failure, leaving the view as it was
+ */
+int table_sorted_view_refresh(table_sorted_view *view)
+{
+  int num_rows = table_get_row_length(view->t);
+
+  if (num_rows > view->allocated || !view->rows)
+  {
+    int allocated = num_rows ? num_rows : 1;
+    int *rows = realloc(view->rows, (size_t)allocated * sizeof(int));
+
+    if (!rows)
+      return -1;
+
+    view->rows = rows;
+    view->allocated = allocated;
+  }
+
+  view->length = table_argsort(view->t, &view->spec, view->rows);
+  view->generation = view->t->generation;
+  return 0;
+}
+
+/**
+ * \brief Determine if a sorted view still covers the rows of its table
+ * \param[in] view The sorted view
+ * \return TRUE or FALSE
+ *
+ * A valid view may still be out of order when values it was sorted by
+ * have been set since.
+ */
+bool table_sorted_view_is_valid(const table_sorted_view *view)
+{
+  return view->generation == view->t->generation && view->length == table_get_row_length(view->t);
+}
+
+/**
+ * \brief Get the number of rows in a sorted view
+ * \param[in] view The sorted view
+ * \return The number of rows
+ */
+int table_sorted_view_get_length(const table_sorted_view *view)
+{
+  return view->length;
+}
+
+/**
+ * \brief Get the table row at an index of a sorted view
+ * \param[in] view The sorted view
+ * \param[in] index The index in the view
+ * \return The table row, to read with table_get() and friends
+ */
+int table_sorted_view_get_row(const table_sorted_view *view, int index)
+{
+  return view->rows[index];
+}
+
+/**
+ * \brief Get a value at an index of a sorted view
+ * \param[in] view The sorted view
+ * \param[in] index The index in the view
+ * \param[in] col The table column
+ * \return The value pointer, or NULL if the cell has no value
+ */
+void *table_sorted_view_get(const table_sorted_view *view, int index, int col)
+{
+  return table_get(view->t, view->rows[index], col);
+}
+
+/**
+ * \brief Binary search a sorted view on a particular column
+ * \param[in] view The sorted view
+ * \param[in] col The column to search, the first column of the view for a meaningful result
+ * \param[in] value The value to match on
+ * \param[in] position The location of the returned index if there are more than one result
+ * \return The index in the view matching given criteria, or the negated index the value would be inserted at
+ */
+int table_sorted_view_find(const table_sorted_view *view, int col, void *value, table_position position)
+{
+  table_order order = view->spec.length && view->spec.cols[0] == col ? view->spec.orders[0] : TABLE_ASCENDING;
+  int low = 0, high = view->length, index;
+
+  while (low < high)
+  {
+    int middle = low + (high - low) / 2;
+    int result = table_sorted_view_compare(view, col, order, value, middle);
+    if (result > 0 || (!result && position == TABLE_LAST))
+      low = middle + 1;
+    else
+      high = middle;
+  }
+
+  index = position == TABLE_FIRST ? low : low - 1;
+  if (index >= 0 && index < view->length && !table_sorted_view_compare(view, col, order, value, index))
+    return index;
+
+  return -low;
+}
+
+/**
+ * \brief Compare a value to the value at an index of a sorted view
+ * \param[in] view The sorted view
+ * \param[in] col The table column
+ * \param[in] order The order of the column in the view
+ * \param[in] value The value
+ * \param[in] index The index in the view
+ * \return Less than, equal to or greater than zero if the value sorts before, with or after the index
+ */
+static int table_sorted_view_compare(const table_sorted_view *view, int col, table_order order, void *value, int index)
+{
+  table_comparator compare = table_get_column_comparator(view->t, col);
+  int result = compare(value, table_sorted_view_get(view, index, col));
+
+  return order == TABLE_ASCENDING ? result : -result;
+}
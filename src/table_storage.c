@@ -0,0 +1,872 @@
+/**
+ * \file
+ * \brief The table storage implementation file
+ *
+ * This file handles the table storage layouts. A row storage column keeps
+ * its values inline in a cell of every row, rows are widened to hold the
+ * cells of new columns the first time one of them is stored. A column storage column owns a
+ * contiguous array of its native data type, sized to the allocated rows of
+ * the table. In both layouts string and pointer columns store their pointers,
+ * every other type stores its value.
+ *
+ * A column storage column may borrow its values from a caller buffer. The
+ * buffer is only ever read, the values are copied into storage owned by the
+ * column before the first modification of the column or of its rows.
+ *
+ * Every column carries a packed validity bitmap with one bit per allocated
+ * row, along with a count of the rows without a value. Bits past the last
+ * row are always clear.
+ */
+#include "table_defs.h"
+
+static void table_bitmap_erase(uint64_t *bitmap, int index, int length);
+
+/**
+ * \brief Set the storage layout used by columns added to the table
+ * \param[out] t The table
+ * \param[in] storage The storage layout
+ */
+void table_set_storage(table *t, table_storage storage)
+{
+  t->storage = storage;
+}
+
+/**
+ * \brief Get the storage layout used by columns added to the table
+ * \param[in] t The table
+ * \return The storage layout
+ */
+table_storage table_get_storage(const table *t)
+{
+  return t->storage;
+}
+
+/**
+ * \brief Get the storage layout of a column
+ * \param[in] t The table
+ * \param[in] col The table column
+ * \return The storage layout
+ */
+table_storage table_get_column_storage(const table *t, int col)
+{
+  return table_get_col_ptr(t, col)->storage;
+}
+
+/**
+ * \brief Move a column to a storage layout
+ * \param[out] t The table
+ * \param[in] col The table column
+ * \param[in] storage The storage layout
+ * \return A return code
+ */
+int table_set_column_storage(table *t, int col, table_storage storage)
+{
+  table_column *column = table_get_col_ptr(t, col);
+  int row_length = table_get_row_length(t);
+  size_t size = table_get_data_type_size(column->type);
+  char *data = NULL;
+
+  if (column->storage == storage)
+    return 0;
+
+  if (storage == TABLE_COLUMN_STORAGE)
+  {
+    if (t->rows_allocated)
+      data = malloc(size * t->rows_allocated);
+
+    for (int row_index = 0; row_index < row_length; row_index++)
+      if (table_storage_has_value(t, row_index, col))
+        memcpy(data + size * row_index, table_storage_get_slot(t, row_index, col), size);
+
+    table_cell_slot_release(t, column->cell_index);
+    column->cell_index = -1;
+    column->data = data;
+    column->storage = TABLE_COLUMN_STORAGE;
+  }
+  else
+  {
+    data = column->data;
+    column->cell_index = table_cell_slot_acquire(t);
+    column->storage = TABLE_ROW_STORAGE;
+
+    for (int row_index = 0; row_index < row_length; row_index++)
+    {
+      if (table_storage_has_value(t, row_index, col))
+      {
+        table_row_widen(t, row_index);
+        memcpy(table_storage_get_slot(t, row_index, col), data + size * row_index, size);
+      }
+    }
+
+    if (data && !column->borrowed)
+      free(data);
+    column->data = NULL;
+    column->borrowed = 0;
+  }
+
+  t->generation++;
+  return 0;
+}
+
+/**
+ * \brief Get a view of the values of a column
+ * \param[out] t The table
+ * \param[in] col The table column
+ * \return The column view
+ *
+ * A row storage column is moved to column storage first, so that its values
+ * can be viewed in place.
+ */
+table_column_view table_get_column_view(table *t, int col)
+{
+  table_column_view view;
+
+  table_set_column_storage(t, col, TABLE_COLUMN_STORAGE);
+  table_storage_get_view(t, col, &view);
+  return view;
+}
+
+/**
+ * \brief Determine if a column view is still valid
+ * \param[in] t The table
+ * \param[in] view The column view
+ * \return TRUE or FALSE
+ *
+ * Views are invalidated by adding or removing rows, sorting, moving or
+ * removing columns, and the first modification of a borrowed column.
+ * Storing values in a column does not invalidate its view. Rows added
+ * within the allocated rows leave the generation alone, so that caches
+ * can follow them, and are told apart by the length of the view.
+ */
+bool table_column_view_is_valid(const table *t, const table_column_view *view)
+{
+  return view->generation == t->generation && view->length == table_get_row_length(t);
+}
+
+/**
+ * \brief Get the number of rows without a value in a column
+ * \param[in] t The table
+ * \param[in] col The table column
+ * \return The number of rows without a value
+ */
+int table_column_null_count(const table *t, int col)
+{
+  return table_get_col_ptr(t, col)->null_count;
+}
+
+/**
+ * \brief Get the validity bitmap of a column
+ * \param[in] t The table
+ * \param[in] col The table column
+ * \return The packed validity bitmap, row n is bit n % 64 of word n / 64
+ *
+ * The bitmap is invalidated by adding or removing rows.
+ */
+const uint64_t *table_get_column_validity(const table *t, int col)
+{
+  return table_get_col_ptr(t, col)->validity;
+}
+
+/**
+ * \brief Get the size of a single value of a data type
+ * \param[in] type The data type
+ * \return The size of the value, pointers for strings
+ */
+size_t table_get_data_type_size(table_data_type type)
+{
+  size_t size = 0;
+
+  switch (type)
+  {
+    case TABLE_INT:
+      size = sizeof(int);
+      break;
+    case TABLE_UINT:
+      size = sizeof(unsigned int);
+      break;
+    case TABLE_INT8:
+      size = sizeof(int8_t);
+      break;
+    case TABLE_UINT8:
+      size = sizeof(uint8_t);
+      break;
+    case TABLE_INT16:
+      size = sizeof(int16_t);
+      break;
+    case TABLE_UINT16:
+      size = sizeof(uint16_t);
+      break;
+    case TABLE_INT32:
+      size = sizeof(int32_t);
+      break;
+    case TABLE_UINT32:
+      size = sizeof(uint32_t);
+      break;
+    case TABLE_INT64:
+      size = sizeof(int64_t);
+      break;
+    case TABLE_UINT64:
+      size = sizeof(uint64_t);
+      break;
+    case TABLE_SHORT:
+      size = sizeof(short);
+      break;
+    case TABLE_USHORT:
+      size = sizeof(unsigned short);
+      break;
+    case TABLE_LONG:
+      size = sizeof(long);
+      break;
+    case TABLE_ULONG:
+      size = sizeof(unsigned long);
+      break;
+    case TABLE_LLONG:
+      size = sizeof(long long);
+      break;
+    case TABLE_ULLONG:
+      size = sizeof(unsigned long long);
+      break;
+    case TABLE_FLOAT:
+      size = sizeof(float);
+      break;
+    case TABLE_DOUBLE:
+      size = sizeof(double);
+      break;
+    case TABLE_LDOUBLE:
+      size = sizeof(long double);
+      break;
+    case TABLE_CHAR:
+      size = sizeof(char);
+      break;
+    case TABLE_UCHAR:
+      size = sizeof(unsigned char);
+      break;
+    case TABLE_STRING:
+      size = sizeof(char*);
+      break;
+    case TABLE_BOOL:
+      size = sizeof(bool);
+      break;
+    case TABLE_PTR:
+      size = sizeof(void*);
+      break;
+  }
+
+  return size;
+}
+
+/**
+ * \brief Allocate the validity bitmap and column storage values of a column
+ * \param[out] t The table
+ * \param[in] column_index The table column
+ *
+ * Every existing row starts out without a value.
+ */
+void table_storage_column_init(table *t, int column_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  size_t size = table_get_data_type_size(column->type);
+
+  column->data = NULL;
+  column->validity = NULL;
+  column->null_count = table_get_row_length(t);
+  column->borrowed = 0;
+  column->prefixes = NULL;
+  column->prefixes_length = 0;
+  column->prefixes_generation = 0;
+
+  if (t->rows_allocated)
+  {
+    if (column->storage == TABLE_COLUMN_STORAGE)
+      column->data = calloc(t->rows_allocated, size);
+    column->validity = calloc(TABLE_BITMAP_WORDS(t->rows_allocated), sizeof(uint64_t));
+  }
+}
+
+/**
+ * \brief Free the validity bitmap and column storage values of a column
+ * \param[out] t The table
+ * \param[in] column_index The table column
+ */
+void table_storage_column_destroy(table *t, int column_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+
+  if (column->data && !column->borrowed)
+    free(column->data);
+
+  if (column->validity)
+    free(column->validity);
+
+  free(column->prefixes);
+
+  column->data = NULL;
+  column->validity = NULL;
+  column->borrowed = 0;
+  column->prefixes = NULL;
+  column->prefixes_length = 0;
+}
+
+/**
+ * \brief Store the values of every row of a column from a buffer
+ * \param[out] t The table
+ * \param[in] column_index The table column, which must use column storage
+ * \param[in] data The values, one per row, which must match the column data type
+ * \param[in] length The number of values, which must match the number of rows
+ * \param[in] ownership Whether the buffer is copied, adopted or borrowed
+ * \return A return code
+ *
+ * Only copied buffers may hold strings. A NULL pointer leaves its cell
+ * without a value.
+ */
+int table_storage_column_from_buffer(table *t, int column_index, void *data, size_t length, table_ownership ownership)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  size_t size = table_get_data_type_size(column->type);
+
+  if (ownership == TABLE_COPY || !length)
+    return table_storage_set_range(t, 0, column_index, length, data, size);
+
+  if (ownership == TABLE_BORROW)
+  {
+    column->borrowed = length;
+  }
+  else if (t->rows_allocated > length)
+  {
+    /* Adopted values are sized to the allocated rows like any other */
+    data = realloc(data, size * t->rows_allocated);
+    if (!data)
+      return -1;
+  }
+
+  if (column->data)
+    free(column->data);
+  column->data = data;
+
+  for (size_t row_index = 0; row_index < length; row_index++)
+    if (column->type != TABLE_PTR || ((void**)data)[row_index])
+      table_storage_set_has_value(t, row_index, column_index, true);
+
+  return 0;
+}
+
+/**
+ * \brief Fill in a view of the values of a column
+ * \param[in] t The table
+ * \param[in] column_index The table column
+ * \param[out] view The column view, with a NULL base for a row storage column
+ */
+void table_storage_get_view(const table *t, int column_index, table_column_view *view)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+
+  view->base = column->storage == TABLE_COLUMN_STORAGE ? column->data : NULL;
+  view->stride = table_get_data_type_size(column->type);
+  view->length = table_get_row_length(t);
+  view->type = column->type;
+  view->validity = column->validity;
+  view->null_count = column->null_count;
+  view->generation = t->generation;
+}
+
+/**
+ * \brief Copy the borrowed values of a column into storage owned by the column
+ * \param[out] t The table
+ * \param[in] column_index The table column
+ */
+void table_storage_own_column(table *t, int column_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  size_t size = table_get_data_type_size(column->type);
+  void *data;
+
+  if (!column->borrowed)
+    return;
+
+  data = malloc(size * t->rows_allocated);
+  memcpy(data, column->data, size * column->borrowed);
+  column->data = data;
+  column->borrowed = 0;
+  t->generation++;
+}
+
+/**
+ * \brief Resize every column to the allocated rows of the table
+ * \param[out] t The table
+ * \param[in] previous_allocated The number of rows previously allocated
+ */
+void table_storage_resize_rows(table *t, size_t previous_allocated)
+{
+  int column_length = table_get_column_length(t);
+  size_t previous_words = TABLE_BITMAP_WORDS(previous_allocated);
+  size_t words = TABLE_BITMAP_WORDS(t->rows_allocated);
+
+  t->generation++;
+  for (int column_index = 0; column_index < column_length; column_index++)
+  {
+    table_column *column = table_get_col_ptr(t, column_index);
+    size_t size = table_get_data_type_size(column->type);
+
+    if (!t->rows_allocated)
+    {
+      table_storage_column_destroy(t, column_index);
+      continue;
+    }
+
+    if (column->storage == TABLE_COLUMN_STORAGE)
+    {
+      table_storage_own_column(t, column_index);
+      column->data = realloc(column->data, size * t->rows_allocated);
+    }
+
+    if (words != previous_words)
+      column->validity = realloc(column->validity, sizeof(uint64_t) * words);
+
+    if (words > previous_words)
+      memset(column->validity + previous_words, 0, sizeof(uint64_t) * (words - previous_words));
+  }
+}
+
+/**
+ * \brief Remove a row from every column
+ * \param[out] t The table
+ * \param[in] row_index The row to remove, the row length must not yet be decremented
+ *
+ * The row values must already have been destroyed.
+ */
+void table_storage_remove_row(table *t, int row_index)
+{
+  int column_length = table_get_column_length(t);
+  int row_length = table_get_row_length(t);
+
+  t->generation++;
+  for (int column_index = 0; column_index < column_length; column_index++)
+  {
+    table_column *column = table_get_col_ptr(t, column_index);
+    size_t size = table_get_data_type_size(column->type);
+
+    if (!TABLE_BITMAP_GET(column->validity, row_index))
+      column->null_count--;
+
+    if (column->storage == TABLE_COLUMN_STORAGE)
+    {
+      char *data;
+
+      table_storage_own_column(t, column_index);
+      data = column->data;
+      memmove(data + size * row_index, data + size * (row_index + 1), size * (row_length - row_index - 1));
+    }
+
+    table_bitmap_erase(column->validity, row_index, row_length);
+  }
+}
+
+/**
+ * \brief Remove every tombstoned row from every column
+ * \param[out] t The table
+ *
+ * The row values must already have been destroyed and the rows must not yet
+ * be compacted.
+ */
+void table_storage_compact_rows(table *t)
+{
+  int column_length = table_get_column_length(t);
+  int row_length = table_get_row_length(t);
+  int first = 0;
+
+  t->generation++;
+
+  /* Rows before the first tombstone stay where they are */
+  while (first < row_length && !table_row_is_removed(t, first))
+    first++;
+
+  for (int column_index = 0; column_index < column_length; column_index++)
+  {
+    table_column *column = table_get_col_ptr(t, column_index);
+    size_t size = table_get_data_type_size(column->type);
+    char *data;
+    int kept = first;
+
+    table_storage_own_column(t, column_index);
+    data = column->data;
+
+    for (int row_index = first; row_index < row_length; row_index++)
+    {
+      bool valid = TABLE_BITMAP_GET(column->validity, row_index);
+
+      if (table_row_is_removed(t, row_index))
+      {
+        if (!valid)
+          column->null_count--;
+        continue;
+      }
+
+      if (column->storage == TABLE_COLUMN_STORAGE)
+        memcpy(data + size * kept, data + size * row_index, size);
+
+      if (valid)
+        TABLE_BITMAP_SET(column->validity, kept);
+      else
+        TABLE_BITMAP_CLEAR(column->validity, kept);
+      kept++;
+    }
+
+    for (int row_index = kept; row_index < row_length; row_index++)
+      TABLE_BITMAP_CLEAR(column->validity, row_index);
+  }
+}
+
+/**
+ * \brief Reorder a range of rows in every column
+ * \param[out] t The table
+ * \param[in] first The first row of the range
+ * \param[in] order The source row of each row in the range
+ * \param[in] length The number of rows in the range
+ *
+ * Row storage values move with their rows, so only the validity bitmaps and
+ * column storage values are reordered here.
+ */
+void table_storage_permute_rows(table *t, int first, const int *order, int length)
+{
+  int column_length = table_get_column_length(t);
+  uint64_t *validity = NULL;
+  char *values = NULL;
+  size_t values_size = 0;
+
+  t->generation++;
+  if (column_length)
+    validity = malloc(sizeof(uint64_t) * TABLE_BITMAP_WORDS(length));
+
+  for (int column_index = 0; column_index < column_length; column_index++)
+  {
+    table_column *column = table_get_col_ptr(t, column_index);
+    size_t size = table_get_data_type_size(column->type);
+    char *data;
+
+    table_storage_own_column(t, column_index);
+    data = column->data;
+    if (column->storage == TABLE_COLUMN_STORAGE)
+    {
+      if (values_size < size * length)
+      {
+        values_size = size * length;
+        values = realloc(values, values_size);
+      }
+
+      for (int i = 0; i < length; i++)
+        memcpy(values + size * i, data + size * order[i], size);
+      memcpy(data + size * first, values, size * length);
+    }
+
+    /* A dense column has every bit set, so there is nothing to reorder */
+    if (!column->null_count)
+      continue;
+
+    memset(validity, 0, sizeof(uint64_t) * TABLE_BITMAP_WORDS(length));
+    for (int i = 0; i < length; i++)
+      if (TABLE_BITMAP_GET(column->validity, order[i]))
+        TABLE_BITMAP_SET(validity, i);
+
+    for (int i = 0; i < length; i++)
+    {
+      if (TABLE_BITMAP_GET(validity, i))
+        TABLE_BITMAP_SET(column->validity, first + i);
+      else
+        TABLE_BITMAP_CLEAR(column->validity, first + i);
+    }
+  }
+
+  if (validity)
+    free(validity);
+
+  if (values)
+    free(values);
+}
+
+/**
+ * \brief Get the address of a stored value
+ * \param[in] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \return The address of the value within the row cell or column array
+ */
+void *table_storage_get_slot(const table *t, int row_index, int column_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+
+  if (column->storage == TABLE_ROW_STORAGE)
+    return &table_get_cell_ptr(t, row_index, column_index)->value;
+
+  return (char*)column->data + table_get_data_type_size(column->type) * row_index;
+}
+
+/**
+ * \brief Determine if a stored value is present
+ * \param[in] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \return TRUE or FALSE
+ */
+bool table_storage_has_value(const table *t, int row_index, int column_index)
+{
+  return TABLE_BITMAP_GET(table_get_col_ptr(t, column_index)->validity, row_index);
+}
+
+/**
+ * \brief Mark a stored value as present or absent
+ * \param[out] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \param[in] has_value Whether the value is present
+ */
+void table_storage_set_has_value(table *t, int row_index, int column_index, bool has_value)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+
+  if (has_value == (bool)TABLE_BITMAP_GET(column->validity, row_index))
+    return;
+
+  if (has_value)
+  {
+    TABLE_BITMAP_SET(column->validity, row_index);
+    column->null_count--;
+  }
+  else
+  {
+    TABLE_BITMAP_CLEAR(column->validity, row_index);
+    column->null_count++;
+  }
+}
+
+/**
+ * \brief Get a stored value without checking that it is present
+ * \param[in] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \return The value pointer
+ */
+void *table_storage_get_value(const table *t, int row_index, int column_index)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  void *slot = table_storage_get_slot(t, row_index, column_index);
+
+  if (column->type == TABLE_STRING || column->type == TABLE_PTR)
+    return *(void**)slot;
+
+  return slot;
+}
+
+/**
+ * \brief Get a stored value
+ * \param[in] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \return The value pointer, or NULL if the cell has no value
+ */
+void *table_storage_get(const table *t, int row_index, int column_index)
+{
+  if (!table_storage_has_value(t, row_index, column_index))
+    return NULL;
+
+  return table_storage_get_value(t, row_index, column_index);
+}
+
+/**
+ * \brief Store a value
+ * \param[out] t The table
+ * \param[in] row_index The table row
+ * \param[in] column_index The table column
+ * \param[in] value The value, which must match the column data type
+ * \return A return code
+ *
+ * Only strings are allocated, every other value is copied in place. With
+ * the arena enabled a string is rewritten in place when the new value fits.
+ * Rows awaiting compaction take no values, as compaction only drops them.
+ */
+int table_storage_set(table *t, int row_index, int column_index, void *value)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  void *slot;
+
+  if (table_row_is_removed(t, row_index))
+    return -1;
+
+  if (column->storage == TABLE_ROW_STORAGE)
+    table_row_widen(t, row_index);
+  else
+    table_storage_own_column(t, column_index);
+
+  slot = table_storage_get_slot(t, row_index, column_index);
+  switch (column->type)
+  {
+    case TABLE_STRING:
+      {
+        char *string = table_storage_has_value(t, row_index, column_index) ? *(char**)slot : NULL;
+        size_t size = strlen(value) + 1;
+        if (!t->slab_size)
+          string = realloc(string, size);
+        else if (!string || strlen(string) + 1 < size)
+          string = table_arena_alloc(t, size, 1);
+        if (!string)
+          return -1;
+        memmove(string, value, size);
+        *(char**)slot = string;
+
+        if (row_index < column->prefixes_length && column->prefixes_generation == t->generation)
+          column->prefixes[row_index] = table_string_prefix(string);
+      }
+      break;
+    case TABLE_PTR:
+      *(void**)slot = value;
+      table_storage_set_has_value(t, row_index, column_index, value != NULL);
+      return 0;
+    default:
+      memcpy(slot, value, table_get_data_type_size(column->type));
+      break;
+  }
+
+  table_storage_set_has_value(t, row_index, column_index, true);
+  return 0;
+}
+
+/**
+ * \brief Get the normalised prefix of a string
+ * \param[in] value The string
+ * \return The first 8 bytes of the string as a big-endian integer, padded with zeros
+ *
+ * Prefixes order as strcmp() orders their strings, as far as they go. Equal
+ * prefixes with a zero low byte belong to equal strings.
+ */
+uint64_t table_string_prefix(const char *value)
+{
+  uint64_t prefix = 0;
+
+  for (int i = 0; i < 8 && value[i]; i++)
+    prefix |= (uint64_t)(unsigned char)value[i] << (56 - 8 * i);
+
+  return prefix;
+}
+
+/**
+ * \brief Get the cached string prefixes of a string column
+ * \param[in] t The table
+ * \param[in] column_index The table column
+ * \param[in] cache Whether to cache the prefixes when they are not
+ * \return The prefix of each row, 0 for rows without a value, or NULL when not cached
+ *
+ * The cache follows values set and rows appended. It is rebuilt after rows
+ * are removed or moved. Caching is not safe from several threads at once.
+ */
+const uint64_t *table_storage_get_prefixes(const table *t, int column_index, bool cache)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  int row_length = table_get_row_length(t);
+  int first = column->prefixes_generation == t->generation ? column->prefixes_length : 0;
+
+  if (column->prefixes && first == row_length)
+    return column->prefixes;
+
+  if (!cache)
+    return NULL;
+
+  /* Rows are only appended within the allocated rows until the generation changes */
+  if (!first)
+  {
+    uint64_t *prefixes = realloc(column->prefixes, (t->rows_allocated ? t->rows_allocated : 1) * sizeof(uint64_t));
+    if (!prefixes)
+      return NULL;
+    column->prefixes = prefixes;
+  }
+
+  for (int row_index = first; row_index < row_length; row_index++)
+    column->prefixes[row_index] = table_storage_has_value(t, row_index, column_index) ?
+      table_string_prefix(table_storage_get_value(t, row_index, column_index)) : 0;
+
+  column->prefixes_length = row_length;
+  column->prefixes_generation = t->generation;
+  return column->prefixes;
+}
+
+/**
+ * \brief Store the values of a range of rows in a column
+ * \param[out] t The table
+ * \param[in] first_row The first row of the range
+ * \param[in] column_index The table column
+ * \param[in] length The number of rows in the range
+ * \param[in] values The first value, which must match the column data type
+ * \param[in] stride The distance in bytes between consecutive values
+ * \return A return code
+ *
+ * Values are copied without any alignment requirement. A NULL string or
+ * pointer leaves its cell without a value. Rows awaiting compaction are
+ * passed over.
+ */
+int table_storage_set_range(table *t, int first_row, int column_index, int length, const char *values, size_t stride)
+{
+  table_column *column = table_get_col_ptr(t, column_index);
+  size_t size = table_get_data_type_size(column->type);
+
+  if (column->type == TABLE_STRING || column->type == TABLE_PTR)
+  {
+    for (int i = 0; i < length; i++)
+    {
+      void *value;
+      memcpy(&value, values + stride * i, sizeof(void*));
+
+      if (table_row_is_removed(t, first_row + i))
+        continue;
+      if (!value)
+        table_cell_nullify(t, first_row + i, column_index);
+      else if (table_storage_set(t, first_row + i, column_index, value))
+        return -1;
+    }
+    return 0;
+  }
+
+  if (column->storage == TABLE_COLUMN_STORAGE)
+  {
+    char *data;
+
+    table_storage_own_column(t, column_index);
+    data = (char*)column->data + size * first_row;
+    if (stride == size)
+      memcpy(data, values, size * length);
+    else
+      for (int i = 0; i < length; i++)
+        memcpy(data + size * i, values + stride * i, size);
+  }
+  else
+  {
+    for (int i = 0; i < length; i++)
+    {
+      table_row_widen(t, first_row + i);
+      memcpy(table_storage_get_slot(t, first_row + i, column_index), values + stride * i, size);
+    }
+  }
+
+  for (int i = 0; i < length; i++)
+    if (!table_row_is_removed(t, first_row + i))
+      table_storage_set_has_value(t, first_row + i, column_index, true);
+
+  return 0;
+}
+
+/**
+ * \brief Remove a bit from a bitmap, shifting the following bits down
+ * \param[out] bitmap The bitmap
+ * \param[in] index The bit to remove
+ * \param[in] length The number of bits in the bitmap before removal
+ */
+static void table_bitmap_erase(uint64_t *bitmap, int index, int length)
+{
+  int word = index / TABLE_BITMAP_WORD_BITS;
+  int last_word = (length - 1) / TABLE_BITMAP_WORD_BITS;
+  uint64_t low_mask = ((uint64_t)1 << (index % TABLE_BITMAP_WORD_BITS)) - 1;
+
+  bitmap[word] = (bitmap[word] & low_mask) | ((bitmap[word] >> 1) & ~low_mask);
+  for (; word < last_word; word++)
+  {
+    bitmap[word] |= bitmap[word + 1] << (TABLE_BITMAP_WORD_BITS - 1);
+    bitmap[word + 1] >>= 1;
+  }
+}
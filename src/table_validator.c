@@ -69,12 +69,16 @@ int table_cell_is_valid(const table *t, int row, int col)
  */
 int table_cell_has_value(const table *t, int row, int col)
 {
-  table_cell* cell = table_get_cell_ptr(t, row, col);
-  int retval = 0;
-
-  if(cell)
-    if(cell->value)
-      retval = 1;
+  return table_get(t, row, col) ? 1 : 0;
+}
 
-  return retval;
+/**
+ * \brief Determine if every row of a column has a value
+ * \param t The table to be examined
+ * \param col The column number
+ * \return TRUE or FALSE
+ */
+int table_column_is_dense(const table *t, int col)
+{
+  return table_column_null_count(t, col) ? 0 : 1;
 }
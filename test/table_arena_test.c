@@ -0,0 +1,81 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+static void callback(table *t, int row, int col, table_event_type event_type, void *data)
+{
+   if (event_type == TABLE_ROW_REMOVED && row == -1)
+      ++*(int*)data;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int name_col, label_col, value_col, extra_col, row, col, pass;
+   int num_rows = 1000;
+   int cleared = 0;
+   int rc = 0;
+
+   table_init(&t);
+   table_register_callback(&t, callback, &cleared, TABLE_ROW_REMOVED);
+
+   if (table_set_arena(&t, 4096) || table_get_arena(&t) != 4096)
+   {
+      printf("Failed to enable the arena\n");
+      rc = -1;
+   }
+
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   value_col = table_add_column(&t, "value", TABLE_LDOUBLE);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   label_col = table_add_column(&t, "label", TABLE_STRING);
+
+   for (pass = 0; pass < 2; pass++)
+   {
+      for (row = 0; row < num_rows; row++)
+      {
+         char buf[32];
+         snprintf(buf, sizeof(buf), "name-%d", row);
+         table_add_row(&t);
+         table_set_string(&t, row, name_col, "a long placeholder value");
+         table_set_string(&t, row, name_col, buf);
+         table_set_string(&t, row, label_col, buf);
+         table_set_ldouble(&t, row, value_col, row);
+      }
+
+      if (table_set_arena(&t, 0) != -1)
+      {
+         printf("The arena should not be changed while the table has rows\n");
+         rc = -1;
+      }
+
+      table_remove_row(&t, 0);
+
+      table_set_storage(&t, TABLE_ROW_STORAGE);
+      for (col = 0; col < 12; col++)
+      {
+         char buf[32];
+         snprintf(buf, sizeof(buf), "extra-%d-%d", pass, col);
+         extra_col = table_add_column(&t, buf, TABLE_INT);
+         table_set_int(&t, 0, extra_col, col);
+      }
+
+      if (strcmp(table_get_string(&t, 41, name_col), "name-42") || strcmp(table_get_string(&t, 41, label_col), "name-42") ||
+          table_get_ldouble(&t, 41, value_col) != 42 || table_get_int(&t, 0, extra_col) != 11)
+      {
+         printf("Failed to retrieve arena values\n");
+         rc = -1;
+      }
+
+      table_clear(&t);
+      if (table_get_row_length(&t) || table_column_null_count(&t, name_col) || cleared != pass + 1)
+      {
+         printf("Failed to clear the table\n");
+         rc = -1;
+      }
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
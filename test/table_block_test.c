@@ -0,0 +1,128 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+static int notified;
+
+static void count_events(table *t, int row, int column, table_event_type event_type, void *data)
+{
+   notified++;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_data_type types[3] = { TABLE_INT32, TABLE_DOUBLE, TABLE_STRING };
+   table_data_type wrong_types[2] = { TABLE_INT32, TABLE_FLOAT };
+   unsigned char buf[1000 * (sizeof(int32_t) + sizeof(double) + sizeof(char*))];
+   int32_t ids[1000];
+   double values[1000];
+   const char *names[1000];
+   char strings[1000][16];
+   int row, first, num_rows = 1000;
+   int rc = 0;
+
+   table_init(&t);
+   table_register_callback(&t, count_events, NULL, TABLE_ROW_ADDED | TABLE_DATA_MODIFIED);
+
+   table_add_column(&t, "id", TABLE_INT32);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   table_add_column(&t, "value", TABLE_DOUBLE);
+   table_set_storage(&t, TABLE_ROW_STORAGE);
+   table_add_column(&t, "name", TABLE_STRING);
+
+   first = table_append_rows(&t, num_rows);
+   if (first != 0 || table_get_row_length(&t) != num_rows || notified != 1 ||
+       table_column_null_count(&t, 0) != num_rows || table_cell_has_value(&t, 10, 2))
+   {
+      printf("Failed to append rows\n");
+      rc = -1;
+   }
+
+   /* Row major, packed without padding */
+   for (row = 0; row < num_rows; row++)
+   {
+      unsigned char *p = buf + row * (sizeof(int32_t) + sizeof(double) + sizeof(char*));
+      int32_t id = row;
+      double value = row * 0.25;
+      const char *name = NULL;
+
+      snprintf(strings[row], sizeof(strings[row]), "name-%d", row);
+      if (row % 7)
+         name = strings[row];
+
+      memcpy(p, &id, sizeof(id));
+      memcpy(p + sizeof(id), &value, sizeof(value));
+      memcpy(p + sizeof(id) + sizeof(value), &name, sizeof(name));
+   }
+
+   notified = 0;
+   if (table_set_block(&t, 0, 0, num_rows, 3, buf, types) || notified != 1)
+   {
+      printf("Failed to set a row major block\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < num_rows; row++)
+   {
+      if (table_get_int32(&t, row, 0) != row || table_get_double(&t, row, 1) != row * 0.25 ||
+          table_cell_has_value(&t, row, 2) != (row % 7 != 0) ||
+          (row % 7 && strcmp(table_get_string(&t, row, 2), strings[row])))
+      {
+         printf("Row %d was not set from the row major block\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   if (table_column_null_count(&t, 0) || table_column_null_count(&t, 2) != (num_rows + 6) / 7)
+   {
+      printf("Unexpected null counts after setting a block\n");
+      rc = -1;
+   }
+
+   /* Column major, overwriting part of the table */
+   for (row = 0; row < 500; row++)
+   {
+      ids[row] = -row;
+      values[row] = row * 2.0;
+      names[row] = strings[999 - row];
+   }
+
+   memcpy(buf, ids, sizeof(int32_t) * 500);
+   memcpy(buf + sizeof(int32_t) * 500, values, sizeof(double) * 500);
+   memcpy(buf + (sizeof(int32_t) + sizeof(double)) * 500, names, sizeof(char*) * 500);
+   if (table_set_block_column_major(&t, 250, 0, 500, 3, buf, types) || notified != 2)
+   {
+      printf("Failed to set a column major block\n");
+      rc = -1;
+   }
+
+   for (row = 250; row < 750; row++)
+   {
+      if (table_get_int32(&t, row, 0) != 250 - row || table_get_double(&t, row, 1) != (row - 250) * 2.0 ||
+          strcmp(table_get_string(&t, row, 2), strings[1249 - row]))
+      {
+         printf("Row %d was not set from the column major block\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   if (table_get_int32(&t, 750, 0) != 750 || table_column_null_count(&t, 2) != (num_rows + 6) / 7 - 72)
+   {
+      printf("Cells outside the column major block were modified\n");
+      rc = -1;
+   }
+
+   if (!table_set_block(&t, 0, 0, 1, 2, buf, wrong_types) || !table_set_block(&t, 999, 0, 2, 3, buf, types) ||
+       notified != 2)
+   {
+      printf("Accepted an invalid block\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,89 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int64_t *adopted;
+   double borrowed[1000];
+   int ints[999];
+   void *ptrs[1000];
+   int ids, values, col, row, num_rows = 1000;
+   int rc = 0;
+
+   table_init(&t);
+
+   adopted = malloc(sizeof(int64_t) * num_rows);
+   for (row = 0; row < num_rows; row++)
+   {
+      adopted[row] = row * 3;
+      borrowed[row] = row * 0.5;
+      ptrs[row] = row % 2 ? &ptrs[row] : NULL;
+   }
+
+   ids = table_add_column_from_buffer(&t, "id", TABLE_INT64, adopted, num_rows, TABLE_ADOPT);
+   values = table_add_column_from_buffer(&t, "value", TABLE_DOUBLE, borrowed, num_rows, TABLE_BORROW);
+   col = table_add_column_from_buffer(&t, "ptr", TABLE_PTR, ptrs, num_rows, TABLE_COPY);
+   if (ids != 0 || values != 1 || col != 2 || table_get_row_length(&t) != num_rows ||
+       table_get_column_storage(&t, ids) != TABLE_COLUMN_STORAGE || table_column_null_count(&t, values) ||
+       table_column_null_count(&t, col) != num_rows / 2 || table_get_ptr(&t, 3, col) != &ptrs[3])
+   {
+      printf("Failed to add columns from buffers\n");
+      rc = -1;
+   }
+
+   if (t.columns[values].data != borrowed || t.columns[ids].data != adopted)
+   {
+      printf("Adopted or borrowed buffers were copied\n");
+      rc = -1;
+   }
+
+   if (table_get_int64(&t, 42, ids) != 126 || table_get_double(&t, 42, values) != 21.0 ||
+       table_find_double(&t, values, 100.0, TABLE_ASCENDING) != 200 ||
+       table_sorted_find_int64(&t, ids, 300, TABLE_FIRST) != 100)
+   {
+      printf("Failed to read buffer columns\n");
+      rc = -1;
+   }
+
+   if (table_add_column_from_buffer(&t, "short", TABLE_INT, ints, 999, TABLE_COPY) != -1 ||
+       table_add_column_from_buffer(&t, "name", TABLE_STRING, ptrs, num_rows, TABLE_BORROW) != -1 ||
+       table_get_column_length(&t) != 3)
+   {
+      printf("Accepted a buffer that does not fit the table\n");
+      rc = -1;
+   }
+
+   /* Modifying a borrowed column copies it first */
+   table_set_double(&t, 10, values, -1.0);
+   table_remove_row(&t, 0);
+   table_add_row(&t);
+   if (borrowed[10] != 5.0 || borrowed[0] != 0.0 || t.columns[values].data == borrowed ||
+       table_get_double(&t, 9, values) != -1.0 || table_get_double(&t, 10, values) != 5.5 ||
+       table_get_int64(&t, 0, ids) != 3 || table_cell_has_value(&t, num_rows - 1, values))
+   {
+      printf("Borrowed buffer was not copied on modification\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   /* Rows appended within the reserved rows are past the end of a borrowed buffer */
+   table_init(&t);
+   table_reserve_rows(&t, 100);
+   for (row = 0; row < 40; row++)
+      ints[row] = row;
+   col = table_add_column_from_buffer(&t, "borrowed", TABLE_INT, ints, 40, TABLE_BORROW);
+   if (table_append_rows(&t, 24) != 40 || t.columns[col].data == ints || table_column_null_count(&t, col) != 24 ||
+       table_find_int(&t, col, 39, TABLE_ASCENDING) != 39 || table_find_int(&t, col, 40, TABLE_ASCENDING) != -1 ||
+       table_get_column_view(&t, col).length != 64)
+   {
+      printf("Appending rows read past a borrowed buffer\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,140 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_ROWS 3000
+
+/* The first row and the row after the last found by a scan, or where the value would go */
+static int scan(const table *t, int col, void *value, table_order order, int *first, int *last)
+{
+   table_comparator compare = table_get_column_comparator(t, col);
+   int num_rows = table_get_row_length(t);
+   int row = 0;
+
+   while (row < num_rows)
+   {
+      int result = compare(value, table_get(t, row, col));
+      if ((order == TABLE_ASCENDING ? result : -result) <= 0)
+         break;
+      row++;
+   }
+   *first = row;
+
+   while (row < num_rows && !compare(value, table_get(t, row, col)))
+      row++;
+   *last = row;
+
+   return *last - *first;
+}
+
+static int check(const table *t, int col, void *value, table_order order, const char *stage)
+{
+   int first, last, expected_first, expected_last;
+   int count = table_sorted_equal_range(t, col, value, &first, &last);
+   int expected = scan(t, col, value, order, &expected_first, &expected_last);
+
+   if (count != expected || first != expected_first || last != expected_last ||
+       table_sorted_lower_bound(t, col, value) != expected_first ||
+       table_sorted_upper_bound(t, col, value) != expected_last ||
+       table_sorted_count(t, col, value) != expected)
+   {
+      printf("Equal range [%d, %d) disagrees with a scan [%d, %d) after %s\n",
+             first, last, expected_first, expected_last, stage);
+      return -1;
+   }
+
+   return 0;
+}
+
+static int check_columns(table *t, table_order order, const char *stage)
+{
+   int cols[1];
+   table_order orders[1];
+   int rc = 0;
+
+   orders[0] = order;
+   for (int col = 0; col < 3; col++)
+   {
+      cols[0] = col;
+      table_column_sort(t, cols, orders, 1);
+
+      for (int value = -1; value <= 5; value++)
+      {
+         int8_t status = (int8_t)value;
+         char name[16];
+
+         snprintf(name, sizeof(name), "status-%d", value);
+         if (col == 0)
+            rc |= check(t, col, &status, order, stage);
+         else if (col == 1)
+            rc |= check(t, col, name, order, stage);
+         else
+            rc |= check(t, col, &value, order, stage);
+      }
+      rc |= check(t, col, NULL, order, stage);
+   }
+
+   return rc;
+}
+
+static int compare_mod_4(const void *value1, const void *value2)
+{
+   int a, b;
+
+   if (!value1 || !value2)
+      return (value1 != NULL) - (value2 != NULL);
+
+   a = *(const int*)value1 % 4;
+   b = *(const int*)value2 % 4;
+   return (a > b) - (a < b);
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int row, first, last, rc = 0;
+   int cols[1] = { 0 };
+   table_order orders[1] = { TABLE_DESCENDING };
+   int8_t status = 2;
+
+   srand(25);
+   table_init(&t);
+
+   table_add_column(&t, "status", TABLE_INT8);
+   table_add_column(&t, "name", TABLE_STRING);
+   table_add_column(&t, "mod", TABLE_INT);
+   table_set_column_comparator(&t, 2, compare_mod_4);
+
+   for (row = 0; row < NUM_ROWS; row++)
+   {
+      char name[16];
+      int value = rand() % 4;
+
+      snprintf(name, sizeof(name), "status-%d", value);
+      table_add_row(&t);
+      if (rand() % 10)
+         table_set_int8(&t, row, 0, (int8_t)value);
+      if (rand() % 10)
+         table_set_string(&t, row, 1, name);
+      table_set_int(&t, row, 2, rand() % 100);
+   }
+
+   rc |= check_columns(&t, TABLE_ASCENDING, "sorting in ascending order");
+   rc |= check_columns(&t, TABLE_DESCENDING, "sorting in descending order");
+
+   /* A subset is searched in the order given */
+   table_column_sort(&t, cols, orders, 1);
+   if (table_sorted_subset_equal_range(&t, 0, &status, TABLE_DESCENDING, 100, 2000, &first, &last) != last - first ||
+       first < 100 || last > 2001 || table_get_int8(&t, first, 0) != 2 || table_get_int8(&t, last - 1, 0) != 2 ||
+       (first > 100 && table_get_int8(&t, first - 1, 0) != 3) ||
+       (last <= 2000 && table_get_int8(&t, last, 0) != 1))
+   {
+      printf("Failed to find the equal range of a subset\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,124 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_sort_spec spec;
+   table_external_sort_options options = { NULL, 1 };
+   int key_col, name_col, seq_col, row, num_rows = 20000;
+   int cols[2];
+   table_order orders[2] = { TABLE_ASCENDING, TABLE_DESCENDING };
+   int *perm = malloc(num_rows * sizeof(int));
+   FILE *stream;
+   char line[64], expected[64];
+   int rc = 0;
+
+   srand(11);
+   table_init(&t);
+
+   key_col = table_add_column(&t, "key", TABLE_INT32);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "n%d", rand() % 50);
+      table_add_row(&t);
+      if (rand() % 10)
+         table_set_int32(&t, row, key_col, rand() % 1000 - 500);
+      table_set_string(&t, row, name_col, buf);
+      table_set_int(&t, row, seq_col, row);
+   }
+
+   /* Sorting by name then key spills more runs than can be merged at once */
+   cols[0] = name_col;
+   cols[1] = key_col;
+   table_sort_spec_init(&spec, cols, orders, 2);
+   table_argsort(&t, &spec, perm);
+
+   stream = tmpfile();
+   if (table_sort_external_to_stream(&t, &spec, &options, stream))
+   {
+      printf("Failed to sort to a stream\n");
+      rc = -1;
+   }
+
+   rewind(stream);
+   for (row = 0; row < num_rows && !rc; row++)
+   {
+      int r = perm[row];
+      if (table_cell_has_value(&t, r, key_col))
+         snprintf(expected, sizeof(expected), "%d\t%s\t%d\n", (int)table_get_int32(&t, r, key_col),
+                  table_get_string(&t, r, name_col), r);
+      else
+         snprintf(expected, sizeof(expected), "\t%s\t%d\n", table_get_string(&t, r, name_col), r);
+
+      if (!fgets(line, sizeof(line), stream) || strcmp(line, expected))
+      {
+         printf("Line %d of the stream is not in sort order\n", row);
+         rc = -1;
+      }
+   }
+   fclose(stream);
+
+   options.temp_dir = ".";
+   options.memory_budget = 100000;
+   if (table_sort_external(&t, &spec, &options))
+   {
+      printf("Failed to sort the table externally\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < num_rows; row++)
+   {
+      if (table_get_int(&t, row, seq_col) != perm[row])
+      {
+         printf("Row %d does not match the in-memory sort\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   if (!table_is_sorted(&t))
+   {
+      printf("Externally sorted table is not known to be sorted\n");
+      rc = -1;
+   }
+   table_sort_spec_destroy(&spec);
+
+   /* A single key sort that fits in one run */
+   cols[0] = key_col;
+   table_sort_spec_init(&spec, cols, orders + 1, 1);
+   table_argsort(&t, &spec, perm);
+   for (row = 0; row < num_rows; row++)
+      perm[row] = table_get_int(&t, perm[row], seq_col);
+
+   options.memory_budget = 0;
+   table_sort_external(&t, &spec, &options);
+   for (row = 0; row < num_rows; row++)
+   {
+      if (table_get_int(&t, row, seq_col) != perm[row])
+      {
+         printf("Row %d does not match the single run sort\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   options.temp_dir = "./no-such-directory";
+   options.memory_budget = 1;
+   if (table_sort_external(&t, &spec, &options) != -1)
+   {
+      printf("Sorting to a missing directory did not fail\n");
+      rc = -1;
+   }
+   table_sort_spec_destroy(&spec);
+
+   free(perm);
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,165 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The rows table_subset_find() finds one after another */
+static int repeated_find(const table *t, int col, void *value, int minimum, int maximum, int limit, int *rows)
+{
+   int count = 0;
+
+   while (count < limit && minimum <= maximum)
+   {
+      int row = table_subset_find(t, col, value, TABLE_ASCENDING, minimum, maximum);
+      if (row == TABLE_INDEX_NOT_FOUND)
+         break;
+      rows[count++] = row;
+      minimum = row + 1;
+   }
+
+   return count;
+}
+
+static int check(const table *t, int col, void *value, table_selection *selection, const char *stage)
+{
+   int num_rows = table_get_row_length(t);
+   int *rows = malloc(num_rows * sizeof(int) + 1);
+   int rc = 0;
+
+   for (int i = 0; i < 20 && !rc; i++)
+   {
+      int minimum = i ? rand() % num_rows : 0;
+      int maximum = i ? minimum + rand() % (num_rows - minimum) : num_rows - 1;
+      int limit = i % 3 ? num_rows : rand() % 10;
+      int expected = repeated_find(t, col, value, minimum, maximum, limit, rows);
+
+      if (table_subset_find_all(t, col, value, minimum, maximum, limit, selection) != expected ||
+          table_selection_get_length(selection) != expected ||
+          (expected && memcmp(selection->rows, rows, expected * sizeof(int))) ||
+          table_subset_find_all(t, col, value, minimum, maximum, limit, NULL) != expected)
+      {
+         printf("Find all in column %d over %d to %d disagrees with repeated finds after %s\n",
+                col, minimum, maximum, stage);
+         rc = -1;
+      }
+   }
+
+   free(rows);
+   return rc;
+}
+
+static int compare_mod_10(const void *value1, const void *value2)
+{
+   int a, b;
+
+   if (!value1 || !value2)
+      return (value1 != NULL) - (value2 != NULL);
+
+   a = *(const int*)value1 % 10;
+   b = *(const int*)value2 % 10;
+   return (a > b) - (a < b);
+}
+
+static int check_table(table *t, const char *stage)
+{
+   table_selection selection;
+   int rc = 0;
+
+   table_selection_init(&selection);
+   for (int value = 0; value < 12 && !rc; value++)
+   {
+      int8_t small = (int8_t)value;
+      char name[16];
+
+      snprintf(name, sizeof(name), "name-%d", value);
+      rc |= check(t, 0, &value, &selection, stage);
+      rc |= check(t, 1, &small, &selection, stage);
+      rc |= check(t, 2, name, &selection, stage);
+      rc |= check(t, 3, &value, &selection, stage);
+   }
+   rc |= check(t, 1, NULL, &selection, stage);
+   table_selection_destroy(&selection);
+
+   return rc;
+}
+
+static void fill(table *t, int num_rows)
+{
+   table_add_column(t, "id", TABLE_INT);
+   table_add_column(t, "small", TABLE_INT8);
+   table_add_column(t, "name", TABLE_STRING);
+   table_add_column(t, "mod", TABLE_INT);
+   table_set_column_comparator(t, 3, compare_mod_10);
+
+   for (int row = 0; row < num_rows; row++)
+   {
+      char name[16];
+
+      snprintf(name, sizeof(name), "name-%d", rand() % 12);
+      table_add_row(t);
+      table_set_int(t, row, 0, rand() % 12);
+      if (rand() % 4)
+         table_set_int8(t, row, 1, (int8_t)(rand() % 12));
+      table_set_string(t, row, 2, name);
+      table_set_int(t, row, 3, rand() % 100);
+   }
+}
+
+int main(int argc, char **argv)
+{
+   table rows, columns;
+   table_selection selection;
+   int value, rc = 0;
+
+   srand(24);
+
+   table_init(&rows);
+   fill(&rows, 700);
+   rc |= check_table(&rows, "filling row storage");
+
+   table_init(&columns);
+   table_set_storage(&columns, TABLE_COLUMN_STORAGE);
+   fill(&columns, 700);
+   rc |= check_table(&columns, "filling column storage");
+
+   table_create_hash_index(&columns, 0);
+   table_create_hash_index(&columns, 2);
+   rc |= check_table(&columns, "creating hash indexes");
+
+   /* Counts agree with the selection, and selections feed row removal */
+   table_selection_init(&selection);
+   value = 7;
+   if (table_find_all(&columns, 0, &value, &selection) != table_count(&columns, 0, &value) ||
+       !table_selection_is_valid(&selection) ||
+       !table_selection_contains(&selection, table_selection_get_row(&selection, 0)) ||
+       table_selection_contains(&selection, table_find_int(&columns, 0, 6, TABLE_ASCENDING)))
+   {
+      printf("Failed to read back a selection\n");
+      rc = -1;
+   }
+
+   if (table_find_all_limit(&columns, 0, &value, 3, &selection) != 3 ||
+       table_selection_get_row(&selection, 2) != table_subset_find(&columns, 0, &value, TABLE_ASCENDING,
+                                                                   table_selection_get_row(&selection, 1) + 1, 699))
+   {
+      printf("Failed to limit a selection\n");
+      rc = -1;
+   }
+
+   table_find_all(&columns, 0, &value, &selection);
+   if (table_remove_selection(&rows, &selection) != -1 ||
+       table_remove_selection(&columns, &selection) != table_selection_get_length(&selection) ||
+       table_find_int(&columns, 0, 7, TABLE_ASCENDING) != TABLE_INDEX_NOT_FOUND ||
+       table_selection_is_valid(&selection) || table_remove_selection(&columns, &selection) != -1)
+   {
+      printf("Failed to remove the rows of a selection\n");
+      rc = -1;
+   }
+   rc |= check_table(&columns, "removing a selection");
+
+   table_selection_destroy(&selection);
+   table_destroy(&rows);
+   table_destroy(&columns);
+
+   return rc;
+}
@@ -0,0 +1,158 @@
+#include <table.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NUM_ROWS 1000
+
+static const table_data_type types[] = {
+   TABLE_INT8, TABLE_UINT16, TABLE_INT32, TABLE_INT64, TABLE_FLOAT, TABLE_DOUBLE, TABLE_BOOL, TABLE_CHAR
+};
+#define NUM_TYPES (int)(sizeof(types) / sizeof(types[0]))
+
+static double values[NUM_TYPES][NUM_ROWS];
+static bool valid[NUM_TYPES][NUM_ROWS];
+
+static void set(table *t, int row, int col, double value)
+{
+   switch (types[col])
+   {
+      case TABLE_INT8: table_set_int8(t, row, col, (int8_t)value); break;
+      case TABLE_UINT16: table_set_uint16(t, row, col, (uint16_t)value); break;
+      case TABLE_INT32: table_set_int32(t, row, col, (int32_t)value); break;
+      case TABLE_INT64: table_set_int64(t, row, col, (int64_t)value); break;
+      case TABLE_FLOAT: table_set_float(t, row, col, (float)value); break;
+      case TABLE_DOUBLE: table_set_double(t, row, col, value); break;
+      case TABLE_BOOL: table_set_bool(t, row, col, value != 0); break;
+      default: table_set_char(t, row, col, (char)value); break;
+   }
+}
+
+static int find(const table *t, int col, double value, table_order order, int minimum, int maximum)
+{
+   int8_t i8 = (int8_t)value;
+   uint16_t u16 = (uint16_t)value;
+   int32_t i32 = (int32_t)value;
+   int64_t i64 = (int64_t)value;
+   float f = (float)value;
+   bool b = value != 0;
+   char c = (char)value;
+
+   switch (types[col])
+   {
+      case TABLE_INT8: return table_subset_find(t, col, &i8, order, minimum, maximum);
+      case TABLE_UINT16: return table_subset_find(t, col, &u16, order, minimum, maximum);
+      case TABLE_INT32: return table_subset_find(t, col, &i32, order, minimum, maximum);
+      case TABLE_INT64: return table_subset_find(t, col, &i64, order, minimum, maximum);
+      case TABLE_FLOAT: return table_subset_find(t, col, &f, order, minimum, maximum);
+      case TABLE_DOUBLE: return table_subset_find(t, col, &value, order, minimum, maximum);
+      case TABLE_BOOL: return table_subset_find(t, col, &b, order, minimum, maximum);
+      default: return table_subset_find(t, col, &c, order, minimum, maximum);
+   }
+}
+
+/* Values match as in the scalar kernels, so unordered values match anything */
+static int scan(int col, double value, table_order order, int minimum, int maximum)
+{
+   for (int row = minimum; row <= maximum; row++)
+   {
+      int r = order == TABLE_ASCENDING ? row : maximum - (row - minimum);
+      if (valid[col][r] && !(value < values[col][r]) && !(value > values[col][r]))
+         return r;
+   }
+
+   return TABLE_INDEX_NOT_FOUND;
+}
+
+static int check(const table *t, const char *stage)
+{
+   for (int col = 0; col < NUM_TYPES; col++)
+   {
+      for (int i = 0; i < 400; i++)
+      {
+         double value = types[col] == TABLE_BOOL ? rand() % 2 : rand() % 12;
+         int minimum = rand() % NUM_ROWS;
+         int maximum = minimum + rand() % (NUM_ROWS - minimum);
+         table_order order = i % 2 ? TABLE_DESCENDING : TABLE_ASCENDING;
+
+         if (i % 50 == 0)
+         {
+            minimum = 0;
+            maximum = NUM_ROWS - 1;
+         }
+
+         if (find(t, col, value, order, minimum, maximum) != scan(col, value, order, minimum, maximum))
+         {
+            printf("Find of %g in column %d over %d to %d disagrees with a scan after %s\n",
+                   value, col, minimum, maximum, stage);
+            return -1;
+         }
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int row, col;
+   int rc = 0;
+
+   srand(23);
+   table_init(&t);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+
+   for (col = 0; col < NUM_TYPES; col++)
+      table_add_column(&t, "value", types[col]);
+
+   /* Mostly values that are not searched for, so whole vectors go by without a match */
+   for (row = 0; row < NUM_ROWS; row++)
+   {
+      table_add_row(&t);
+      for (col = 0; col < NUM_TYPES; col++)
+      {
+         double value = types[col] == TABLE_BOOL ? rand() % 20 == 0 : rand() % 20 ? 40 : rand() % 10;
+         set(&t, row, col, value);
+         values[col][row] = value;
+         valid[col][row] = true;
+      }
+   }
+   rc |= check(&t, "filling dense columns");
+
+   /* Signed zeros are equal, and any unordered value matches */
+   table_set_float(&t, 500, 4, -0.0f);
+   table_set_double(&t, 500, 5, -0.0);
+   values[4][500] = values[5][500] = -0.0;
+   if (table_find_float(&t, 4, 0.0f, TABLE_DESCENDING) < 500 || table_find_double(&t, 5, 0.0, TABLE_DESCENDING) < 500)
+   {
+      printf("Failed to find a negative zero\n");
+      rc = -1;
+   }
+   table_set_double(&t, 700, 5, NAN);
+   values[5][700] = NAN;
+   if (table_find_double(&t, 5, 1234.0, TABLE_ASCENDING) != 700)
+   {
+      printf("Failed to match an unordered value\n");
+      rc = -1;
+   }
+   rc |= check(&t, "setting zeros and unordered values");
+
+   /* Rows without a value never match, even when their slots hold the value */
+   for (row = 0; row < NUM_ROWS; row++)
+   {
+      for (col = 0; col < NUM_TYPES; col++)
+      {
+         if (rand() % 3 == 0)
+         {
+            table_cell_nullify(&t, row, col);
+            valid[col][row] = false;
+         }
+      }
+   }
+   rc |= check(&t, "removing values");
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,107 @@
+#include <table.h>
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_growth_policy policy = { 1.0, 0.5 };
+   int col, row, num_rows = 1000;
+   size_t allocated;
+   int rc = 0;
+
+   table_init(&t);
+
+   if (table_reserve_rows(&t, num_rows) || t.rows_allocated != (size_t)num_rows)
+   {
+      printf("Failed to reserve rows\n");
+      rc = -1;
+   }
+
+   if (table_reserve_columns(&t, 4) || t.columns_allocated != 4 || t.cells_allocated != 4)
+   {
+      printf("Failed to reserve columns\n");
+      rc = -1;
+   }
+
+   col = table_add_column(&t, "value", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      table_set_int(&t, row, col, row);
+   }
+
+   if (t.rows_allocated != (size_t)num_rows || t.columns_allocated != 4)
+   {
+      printf("Reserved capacity was reallocated\n");
+      rc = -1;
+   }
+
+   /* Removing down to the reservation never shrinks it */
+   for (row = 0; row < num_rows - 1; row++)
+      table_remove_row(&t, 0);
+
+   if (t.rows_allocated != (size_t)num_rows || table_get_int(&t, 0, col) != num_rows - 1)
+   {
+      printf("Reserved rows were released\n");
+      rc = -1;
+   }
+
+   table_shrink_to_fit(&t);
+   if (t.rows_allocated != 1 || t.columns_allocated != 1 || t.cells_allocated != 1 ||
+       table_get_int(&t, 0, col) != num_rows - 1)
+   {
+      printf("Failed to shrink to fit\n");
+      rc = -1;
+   }
+
+   /* Geometric growth and hysteresis at a block boundary */
+   table_remove_row(&t, 0);
+   for (row = 0; row < num_rows; row++)
+      table_add_row(&t);
+
+   allocated = t.rows_allocated;
+   if (allocated >= 2 * (size_t)num_rows)
+   {
+      printf("Rows did not grow geometrically\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < 100; row++)
+   {
+      table_remove_row(&t, 0);
+      table_add_row(&t);
+   }
+
+   if (t.rows_allocated != allocated)
+   {
+      printf("Rows were reallocated while oscillating\n");
+      rc = -1;
+   }
+
+   while (table_get_row_length(&t) > 1)
+      table_remove_row(&t, 0);
+
+   if (t.rows_allocated >= allocated / 4)
+   {
+      printf("Rows were not shrunk\n");
+      rc = -1;
+   }
+
+   policy.growth_factor = 2.0;
+   if (!table_set_growth_policy(&t, policy))
+   {
+      printf("Accepted a policy without hysteresis\n");
+      rc = -1;
+   }
+
+   policy.shrink_threshold = 0.25;
+   if (table_set_growth_policy(&t, policy) || table_get_growth_policy(&t).shrink_threshold != 0.25)
+   {
+      printf("Failed to set the growth policy\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
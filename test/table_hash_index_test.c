@@ -0,0 +1,123 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int scan(const table *t, int col, int64_t value, table_order order)
+{
+   int num_rows = table_get_row_length(t);
+   int row;
+
+   for (row = 0; row < num_rows; row++)
+   {
+      int r = order == TABLE_ASCENDING ? row : num_rows - 1 - row;
+      if (table_cell_has_value(t, r, col) && table_get_int64(t, r, col) == value)
+         return r;
+   }
+
+   return TABLE_INDEX_NOT_FOUND;
+}
+
+static int check(const table *t, int col, const char *stage)
+{
+   for (int64_t value = -1; value <= 300; value++)
+   {
+      if (table_find_int64(t, col, value, TABLE_ASCENDING) != scan(t, col, value, TABLE_ASCENDING) ||
+          table_find_int64(t, col, value, TABLE_DESCENDING) != scan(t, col, value, TABLE_DESCENDING))
+      {
+         printf("Index find of %d disagrees with a scan after %s\n", (int)value, stage);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int name_col, id_col, value_col, row, num_rows = 2000;
+   int cols[1];
+   table_order orders[1] = { TABLE_DESCENDING };
+   int rc = 0;
+
+   srand(5);
+   table_init(&t);
+
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   id_col = table_add_column(&t, "id", TABLE_INT64);
+   value_col = table_add_column(&t, "value", TABLE_DOUBLE);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      table_add_row(&t);
+      table_set_string(&t, row, name_col, buf);
+      if (rand() % 10)
+         table_set_int64(&t, row, id_col, rand() % 250);
+      table_set_double(&t, row, value_col, row);
+   }
+
+   if (table_create_hash_index(&t, value_col) != -1)
+   {
+      printf("Created a hash index on a floating point column\n");
+      rc = -1;
+   }
+
+   if (table_create_hash_index(&t, id_col) || table_create_hash_index(&t, name_col) ||
+       !table_has_hash_index(&t, id_col))
+   {
+      printf("Failed to create hash indexes\n");
+      rc = -1;
+   }
+   rc |= check(&t, id_col, "creation");
+
+   if (table_find_string(&t, name_col, "name-1234", TABLE_ASCENDING) != 1234 ||
+       table_find_string(&t, name_col, "name-x", TABLE_ASCENDING) != TABLE_INDEX_NOT_FOUND)
+   {
+      printf("Failed to find a string through its hash index\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < 500; row++)
+      table_set_int64(&t, rand() % num_rows, id_col, rand() % 300);
+   for (row = 0; row < 100; row++)
+      table_set_int64(&t, table_add_row(&t), id_col, rand() % 300);
+   table_append_rows(&t, 10);
+   table_set_int64(&t, table_get_row_length(&t) - 1, id_col, 7);
+   rc |= check(&t, id_col, "modification");
+
+   for (row = 0; row < 200; row++)
+      table_remove_row(&t, rand() % table_get_row_length(&t));
+   rc |= check(&t, id_col, "row removal");
+
+   table_set_tombstone_threshold(&t, 0.5);
+   for (row = 0; row < 300; row++)
+      table_remove_row(&t, rand() % table_get_row_length(&t));
+   rc |= check(&t, id_col, "tombstoned row removal");
+
+   cols[0] = id_col;
+   table_column_sort(&t, cols, orders, 1);
+   rc |= check(&t, id_col, "sort");
+
+   table_remove_column(&t, name_col);
+   id_col = table_get_column(&t, "id");
+   table_set_int64(&t, 3, id_col, 299);
+   rc |= check(&t, id_col, "column removal");
+
+   table_drop_hash_index(&t, id_col);
+   rc |= check(&t, id_col, "dropping the index");
+   table_create_hash_index(&t, id_col);
+
+   table_clear(&t);
+   table_set_int64(&t, table_add_row(&t), id_col, 42);
+   if (table_find_int64(&t, id_col, 42, TABLE_DESCENDING) != 0)
+   {
+      printf("Failed to find a value after clearing the table\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
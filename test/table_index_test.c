@@ -0,0 +1,157 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef struct rows
+{
+   int *rows;
+   int length;
+   int limit;
+} rows;
+
+static const table *sorted_table;
+static int sorted_col;
+
+static bool collect(const table *t, int row, void *data)
+{
+   rows *found = data;
+   found->rows[found->length++] = row;
+   return found->length != found->limit;
+}
+
+static int compare_rows(const void *a, const void *b)
+{
+   int row1 = *(const int*)a, row2 = *(const int*)b;
+   double value1 = table_get_double(sorted_table, row1, sorted_col);
+   double value2 = table_get_double(sorted_table, row2, sorted_col);
+
+   if (value1 != value2)
+      return value1 < value2 ? -1 : 1;
+   return row1 - row2;
+}
+
+static int check(table *t, table_index *index, int col, const double *lo, const double *hi, int limit, const char *stage)
+{
+   int num_rows = table_get_row_length(t);
+   int *expected = malloc((num_rows + 1) * sizeof(int));
+   rows found = { malloc((num_rows + 1) * sizeof(int)), 0, limit };
+   int length = 0, visited, rc = 0;
+
+   for (int row = 0; row < num_rows; row++)
+   {
+      double value;
+      if (!table_cell_has_value(t, row, col))
+         continue;
+      value = table_get_double(t, row, col);
+      if ((!lo || value >= *lo) && (!hi || value <= *hi))
+         expected[length++] = row;
+   }
+
+   sorted_table = t;
+   sorted_col = col;
+   qsort(expected, length, sizeof(int), compare_rows);
+   if (limit && length > limit)
+      length = limit;
+
+   visited = table_index_range(index, lo, hi, collect, &found);
+   if (visited != length || found.length != length)
+   {
+      printf("Range visited %d rows instead of %d after %s\n", visited, length, stage);
+      rc = -1;
+   }
+
+   for (int i = 0; !rc && i < length; i++)
+   {
+      if (found.rows[i] != expected[i])
+      {
+         printf("Range row %d is %d instead of %d after %s\n", i, found.rows[i], expected[i], stage);
+         rc = -1;
+      }
+   }
+
+   free(found.rows);
+   free(expected);
+   return rc;
+}
+
+static int check_all(table *t, table_index *index, int col, const char *stage)
+{
+   double lo = 100.0, hi = 250.0, point = 42.0;
+   int rc = 0;
+
+   rc |= check(t, index, col, &lo, &hi, 0, stage);
+   rc |= check(t, index, col, NULL, &hi, 0, stage);
+   rc |= check(t, index, col, &lo, NULL, 0, stage);
+   rc |= check(t, index, col, NULL, NULL, 0, stage);
+   rc |= check(t, index, col, &point, &point, 0, stage);
+   rc |= check(t, index, col, &lo, NULL, 10, stage);
+
+   if (table_index_get_length(index) != table_get_row_length(t) - table_column_null_count(t, col))
+   {
+      printf("Index length is off after %s\n", stage);
+      rc = -1;
+   }
+
+   return rc;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_index *index;
+   int id_col, name_col, price_col, row, num_rows = 5000;
+   int cols[1];
+   table_order orders[1] = { TABLE_ASCENDING };
+   int rc = 0;
+
+   srand(9);
+   table_init(&t);
+
+   id_col = table_add_column(&t, "id", TABLE_INT);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   price_col = table_add_column(&t, "price", TABLE_DOUBLE);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      table_set_int(&t, row, id_col, rand());
+      table_set_string(&t, row, name_col, "item");
+      if (rand() % 8)
+         table_set_double(&t, row, price_col, rand() % 500);
+   }
+
+   cols[0] = id_col;
+   table_column_sort(&t, cols, orders, 1);
+
+   index = table_create_index(&t, price_col);
+   rc |= check_all(&t, index, price_col, "creation");
+
+   for (row = 0; row < 2000; row++)
+      table_set_double(&t, rand() % num_rows, price_col, rand() % 500);
+   for (row = 0; row < 1000; row++)
+      table_set_double(&t, table_add_row(&t), price_col, 42.0);
+   table_append_rows(&t, 20);
+   rc |= check_all(&t, index, price_col, "modification");
+
+   for (row = 0; row < 2500; row++)
+      table_remove_row(&t, rand() % table_get_row_length(&t));
+   rc |= check_all(&t, index, price_col, "row removal");
+
+   table_set_tombstone_threshold(&t, 0.3);
+   for (row = 0; row < 500; row++)
+      table_remove_row(&t, rand() % table_get_row_length(&t));
+   rc |= check_all(&t, index, price_col, "tombstoned row removal");
+
+   orders[0] = TABLE_DESCENDING;
+   table_column_sort(&t, cols, orders, 1);
+   rc |= check_all(&t, index, price_col, "sort");
+
+   table_remove_column(&t, name_col);
+   price_col = table_get_column(&t, "price");
+   table_set_double(&t, 0, price_col, 123.0);
+   rc |= check_all(&t, index, price_col, "column removal");
+
+   table_destroy(&t);
+   table_drop_index(index);
+
+   return rc;
+}
@@ -0,0 +1,88 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int name_col, value_col, ld_col, row, num_rows = 60;
+   int cols[2];
+   table_order orders[2];
+   int rc = 0;
+
+   table_init(&t);
+
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   value_col = table_add_column(&t, "value", TABLE_UINT16);
+   ld_col = table_add_column(&t, "ldouble", TABLE_LDOUBLE);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "name-%02d", (row * 7) % 20);
+      table_add_row(&t);
+      if (row % 6)
+         table_set_string(&t, row, name_col, buf);
+      table_set_uint16(&t, row, value_col, (row * 13) % 60);
+      table_set_ldouble(&t, row, ld_col, (long double)((row * 11) % 30) - 15.0L);
+   }
+
+   if (table_find_string(&t, name_col, "name-14", TABLE_ASCENDING) != 2 ||
+       table_find_string(&t, name_col, "name-14", TABLE_DESCENDING) != 22 ||
+       table_find_string(&t, name_col, "missing", TABLE_ASCENDING) != TABLE_INDEX_NOT_FOUND)
+   {
+      printf("Failed to find string values\n");
+      rc = -1;
+   }
+
+   /* Strings ascending, then values descending */
+   cols[0] = name_col;
+   cols[1] = value_col;
+   orders[0] = TABLE_ASCENDING;
+   orders[1] = TABLE_DESCENDING;
+   table_column_sort(&t, cols, orders, 2);
+   for (row = 1; row < num_rows; row++)
+   {
+      const char *prev = table_get_string(&t, row - 1, name_col), *name = table_get_string(&t, row, name_col);
+      int cmp = !prev || !name ? (prev != NULL) - (name != NULL) : strcmp(prev, name);
+
+      if (cmp > 0 || (!cmp && table_get_uint16(&t, row - 1, value_col) < table_get_uint16(&t, row, value_col)))
+      {
+         printf("Row %d is not sorted on strings\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   /* Rows without a value come first, name-05 is on rows 22 to 24 */
+   if (table_sorted_find_string(&t, name_col, "name-05", TABLE_FIRST) != 22 ||
+       table_sorted_find_string(&t, name_col, "name-05", TABLE_LAST) != 24 ||
+       table_sorted_find_string(&t, name_col, "name-19", TABLE_LAST) != num_rows - 1)
+   {
+      printf("Failed to binary search string values\n");
+      rc = -1;
+   }
+
+   if (table_sorted_find_string(&t, name_col, "zzz", TABLE_FIRST) != -num_rows ||
+       table_sorted_find_string(&t, name_col, "name-05x", TABLE_LAST) != -25)
+   {
+      printf("Binary search of a missing value did not return its negated insertion row\n");
+      rc = -1;
+   }
+
+   cols[0] = ld_col;
+   orders[0] = TABLE_DESCENDING;
+   table_column_sort(&t, cols, orders, 1);
+   for (row = 1; row < num_rows; row++)
+   {
+      if (table_get_ldouble(&t, row - 1, ld_col) < table_get_ldouble(&t, row, ld_col))
+      {
+         printf("Row %d is not sorted on long doubles\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
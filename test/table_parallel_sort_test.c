@@ -0,0 +1,101 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int compare_strings_reversed(const void *value1, const void *value2)
+{
+   if (!value1 || !value2)
+      return (value1 != NULL) - (value2 != NULL);
+
+   return strcmp(value2, value1);
+}
+
+/* Sort serially, then back into the original order and in parallel, the rows must match */
+static int check_parallel(table *t, int *cols, table_order *orders, int num_cols, int seq_col, int num_threads)
+{
+   int num_rows = table_get_row_length(t);
+   int *expected = malloc(num_rows * sizeof(int));
+   int seq_cols[1] = { seq_col };
+   table_order seq_orders[1] = { TABLE_ASCENDING };
+   int row, rc = 0;
+
+   table_column_sort(t, cols, orders, num_cols);
+   for (row = 0; row < num_rows; row++)
+      expected[row] = table_get_int(t, row, seq_col);
+
+   table_column_sort(t, seq_cols, seq_orders, 1);
+   table_column_sort_parallel(t, cols, orders, num_cols, num_threads);
+   for (row = 0; row < num_rows; row++)
+   {
+      if (table_get_int(t, row, seq_col) != expected[row])
+      {
+         printf("Row %d differs from the serial sort with %d threads\n", row, num_threads);
+         rc = -1;
+         break;
+      }
+   }
+
+   table_column_sort(t, seq_cols, seq_orders, 1);
+   free(expected);
+
+   return rc;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int int_col, double_col, string_col, seq_col, row, num_rows = 40000;
+   int cols[3];
+   table_order orders[3];
+   int rc = 0;
+
+   srand(11);
+   table_init(&t);
+
+   int_col = table_add_column(&t, "int", TABLE_INT);
+   double_col = table_add_column(&t, "double", TABLE_DOUBLE);
+   string_col = table_add_column(&t, "string", TABLE_STRING);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "s%d", rand() % 100);
+      table_add_row(&t);
+      if (rand() % 10)
+         table_set_int(&t, row, int_col, rand() % 1000 - 500);
+      table_set_double(&t, row, double_col, (rand() % 20) * 0.25);
+      if (rand() % 10)
+         table_set_string(&t, row, string_col, buf);
+      table_set_int(&t, row, seq_col, row);
+   }
+
+   /* Radix sorted runs */
+   cols[0] = int_col;
+   cols[1] = double_col;
+   orders[0] = TABLE_DESCENDING;
+   orders[1] = TABLE_ASCENDING;
+   if (check_parallel(&t, cols, orders, 2, seq_col, 4) || check_parallel(&t, cols, orders, 2, seq_col, 7))
+      rc = -1;
+
+   /* Merge sorted runs */
+   cols[0] = string_col;
+   cols[1] = int_col;
+   cols[2] = double_col;
+   orders[2] = TABLE_DESCENDING;
+   if (check_parallel(&t, cols, orders, 3, seq_col, 3) || check_parallel(&t, cols, orders, 3, seq_col, 16))
+      rc = -1;
+
+   /* Custom comparators */
+   table_set_column_comparator(&t, string_col, compare_strings_reversed);
+   if (check_parallel(&t, cols, orders, 1, seq_col, 5))
+      rc = -1;
+
+   /* More threads than the table has work for */
+   if (check_parallel(&t, cols, orders, 3, seq_col, 1000))
+      rc = -1;
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,124 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int check_sorted(table *t, int name_col, int seq_col, table_order order)
+{
+   int num_rows = table_get_row_length(t);
+
+   for (int row = 1; row < num_rows; row++)
+   {
+      const char *prev = table_get_string(t, row - 1, name_col), *name = table_get_string(t, row, name_col);
+      int cmp = !prev || !name ? (prev != NULL) - (name != NULL) : strcmp(prev, name);
+
+      if (order == TABLE_DESCENDING)
+         cmp = -cmp;
+
+      if (cmp > 0 || (!cmp && table_get_int(t, row - 1, seq_col) > table_get_int(t, row, seq_col)))
+      {
+         printf("Row %d is not stably sorted %s\n", row, order == TABLE_ASCENDING ? "ascending" : "descending");
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int name_col, seq_col, row, num_rows = 3000;
+   int cols[1];
+   table_order orders[1];
+   int rc = 0;
+
+   srand(9);
+   table_init(&t);
+
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+
+      /* Long shared prefixes, short strings and strings ending at the prefix */
+      switch (rand() % 4)
+      {
+         case 0:
+            snprintf(buf, sizeof(buf), "customer-%05d", rand() % 500);
+            break;
+         case 1:
+            snprintf(buf, sizeof(buf), "c%d", rand() % 50);
+            break;
+         case 2:
+            snprintf(buf, sizeof(buf), "custome%c", 'a' + rand() % 3);
+            break;
+         default:
+            buf[0] = '\0';
+            break;
+      }
+
+      table_add_row(&t);
+      if (rand() % 10)
+         table_set_string(&t, row, name_col, buf);
+   }
+
+   cols[0] = name_col;
+   for (int pass = 0; pass < 2; pass++)
+   {
+      orders[0] = pass ? TABLE_DESCENDING : TABLE_ASCENDING;
+
+      /* Number the rows in their current order, ties must keep it */
+      for (row = 0; row < num_rows; row++)
+         table_set_int(&t, row, seq_col, row);
+
+      table_column_sort(&t, cols, orders, 1);
+      if (check_sorted(&t, name_col, seq_col, orders[0]))
+         rc = -1;
+   }
+
+   orders[0] = TABLE_ASCENDING;
+   table_column_sort(&t, cols, orders, 1);
+
+   /* Searches go through the cached prefixes, which follow values set and rows appended */
+   for (int search = 0; search < 3; search++)
+   {
+      const char *values[] = { "customer-00042", "c7", "customeb" };
+      int first = table_sorted_find_string(&t, name_col, values[search], TABLE_FIRST);
+      int last = table_sorted_find_string(&t, name_col, values[search], TABLE_LAST);
+
+      for (row = 0; row < num_rows; row++)
+      {
+         const char *name = table_get_string(&t, row, name_col);
+         int match = name && !strcmp(name, values[search]);
+         if (match != (row >= first && row <= last && first >= 0))
+         {
+            printf("Binary search for %s found rows %d to %d, which is wrong at row %d\n", values[search], first, last, row);
+            rc = -1;
+            break;
+         }
+      }
+   }
+
+   row = table_sorted_find_string(&t, name_col, "customeb", TABLE_LAST);
+   table_set_string(&t, row, name_col, "customeba");
+   if (table_sorted_find_string(&t, name_col, "customeba", TABLE_FIRST) != row)
+   {
+      printf("The cached prefix of a string set was not updated\n");
+      rc = -1;
+   }
+
+   row = table_add_row(&t);
+   table_set_string(&t, row, name_col, "zzzzzzzzzz");
+   if (table_sorted_find_string(&t, name_col, "zzzzzzzzzz", TABLE_FIRST) != row ||
+       table_sorted_find_string(&t, name_col, "zzzzzzzzzy", TABLE_FIRST) != -row)
+   {
+      printf("The cached prefixes did not follow an appended row\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
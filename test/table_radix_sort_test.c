@@ -0,0 +1,128 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static int reverse_compare(const void *value1, const void *value2)
+{
+   double d1, d2;
+
+   if (!value1 || !value2)
+      return (value1 != NULL) - (value2 != NULL);
+
+   d1 = *(const double*)value1;
+   d2 = *(const double*)value2;
+   return (d1 < d2) - (d1 > d2);
+}
+
+static int compare_rows(table *t, int row1, int row2, int col, table_order order)
+{
+   int has1 = table_cell_has_value(t, row1, col), has2 = table_cell_has_value(t, row2, col);
+   int cmp;
+
+   if (has1 != has2)
+      cmp = has1 - has2;
+   else if (!has1)
+      cmp = 0;
+   else if (table_get_column_data_type(t, col) == TABLE_DOUBLE)
+   {
+      double d1 = table_get_double(t, row1, col), d2 = table_get_double(t, row2, col);
+      cmp = (d1 > d2) - (d1 < d2);
+   }
+   else if (table_get_column_data_type(t, col) == TABLE_INT64)
+   {
+      int64_t i1 = table_get_int64(t, row1, col), i2 = table_get_int64(t, row2, col);
+      cmp = (i1 > i2) - (i1 < i2);
+   }
+   else
+   {
+      uint8_t u1 = table_get_uint8(t, row1, col), u2 = table_get_uint8(t, row2, col);
+      cmp = (u1 > u2) - (u1 < u2);
+   }
+
+   return order == TABLE_ASCENDING ? cmp : -cmp;
+}
+
+static int check_sorted(table *t, const int *cols, const table_order *orders, int ncols, int seq_col)
+{
+   int num_rows = table_get_row_length(t);
+
+   for (int row = 1; row < num_rows; row++)
+   {
+      int cmp = 0;
+
+      for (int i = 0; i < ncols && !cmp; i++)
+         cmp = compare_rows(t, row - 1, row, cols[i], orders[i]);
+
+      if (cmp > 0 || (!cmp && table_get_int(t, row - 1, seq_col) > table_get_int(t, row, seq_col)))
+      {
+         printf("Row %d is not stably sorted\n", row);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int int64_col, double_col, uint8_col, seq_col, row, num_rows = 5000;
+   int cols[2];
+   table_order orders[2];
+   double doubles[] = { -1e300, -2.5, -0.0, 0.0, 1e-310, 2.5, 1e300 };
+   int rc = 0;
+
+   srand(7);
+   table_init(&t);
+
+   int64_col = table_add_column(&t, "int64", TABLE_INT64);
+   double_col = table_add_column(&t, "double", TABLE_DOUBLE);
+   uint8_col = table_add_column(&t, "uint8", TABLE_UINT8);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      if (rand() % 8)
+         table_set_int64(&t, row, int64_col, ((int64_t)(rand() % 2001) - 1000) * 4294967296LL + rand() % 3);
+      if (rand() % 8)
+         table_set_double(&t, row, double_col, doubles[rand() % 7]);
+      table_set_uint8(&t, row, uint8_col, rand() % 256);
+   }
+
+   for (int pass = 0; pass < 4; pass++)
+   {
+      cols[0] = pass < 2 ? int64_col : double_col;
+      cols[1] = uint8_col;
+      orders[0] = pass % 2 ? TABLE_DESCENDING : TABLE_ASCENDING;
+      orders[1] = pass % 2 ? TABLE_ASCENDING : TABLE_DESCENDING;
+
+      /* Number the rows in their current order, ties must keep it */
+      for (row = 0; row < num_rows; row++)
+         table_set_int(&t, row, seq_col, row);
+
+      table_column_sort(&t, cols, orders, pass < 2 ? 2 : 1);
+      if (check_sorted(&t, cols, orders, pass < 2 ? 2 : 1, seq_col))
+         rc = -1;
+   }
+
+   /* A custom comparator falls back to the comparison sort */
+   table_set_column_comparator(&t, double_col, reverse_compare);
+   cols[0] = double_col;
+   orders[0] = TABLE_ASCENDING;
+   table_column_sort(&t, cols, orders, 1);
+   orders[0] = TABLE_DESCENDING;
+   for (row = 1; row < num_rows; row++)
+   {
+      if (compare_rows(&t, row - 1, row, double_col, orders[0]) > 0 &&
+          table_cell_has_value(&t, row - 1, double_col) && table_cell_has_value(&t, row, double_col))
+      {
+         printf("Row %d is not sorted by the custom comparator\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,128 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+static int removed;
+
+static void row_removed(table *t, int row, int column, table_event_type event_type, void *data)
+{
+   removed++;
+}
+
+static bool is_odd(const table *t, int row, void *data)
+{
+   int *col = data;
+   return table_get_int(t, row, *col) % 2;
+}
+
+static int verify(table *t, int id_col, int name_col, int first, int step, int num_rows)
+{
+   for (int row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      int id = first + row * step;
+      snprintf(buf, sizeof(buf), "name-%d", id);
+      if (table_get_int(t, row, id_col) != id || table_get_double(t, row, 2) != id * 0.5 ||
+          strcmp(table_get_string(t, row, name_col), buf))
+      {
+         printf("Row %d was not compacted correctly\n", row);
+         return -1;
+      }
+   }
+
+   return table_get_row_length(t) == num_rows ? 0 : -1;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int id_col, name_col, row, num_rows = 1000;
+   int rows[] = { 999, 3, 1, 997, 3 };
+   char name[32];
+   const char *names[] = { name, "leaked" };
+   table_data_type type = TABLE_STRING;
+   int rc = 0;
+
+   table_init(&t);
+   table_register_callback(&t, row_removed, NULL, TABLE_ROW_REMOVED);
+
+   id_col = table_add_column(&t, "id", TABLE_INT);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   table_add_column(&t, "value", TABLE_DOUBLE);
+
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      table_add_row(&t);
+      table_set_int(&t, row, id_col, row);
+      table_set_string(&t, row, name_col, buf);
+      if (row % 2 == 0)
+         table_set_double(&t, row, 2, row * 0.5);
+   }
+
+   if (table_remove_rows(&t, rows, 5) != 4 || removed != 1 || table_get_row_length(&t) != num_rows - 4 ||
+       table_get_int(&t, 1, id_col) != 2 || table_get_int(&t, 2, id_col) != 4 ||
+       table_column_null_count(&t, 2) != num_rows / 2 - 4)
+   {
+      printf("Failed to remove rows\n");
+      rc = -1;
+   }
+
+   if (table_remove_rows_where(&t, is_odd, &id_col) != num_rows / 2 - 4 || removed != 2 ||
+       table_column_null_count(&t, 2) || verify(&t, id_col, name_col, 0, 2, num_rows / 2))
+   {
+      printf("Failed to remove rows matching a predicate\n");
+      rc = -1;
+   }
+
+   /* Tombstones keep every row in place until the threshold is crossed */
+   table_set_tombstone_threshold(&t, 0.5);
+   num_rows = table_get_row_length(&t);
+   for (row = 1; row < num_rows; row += 2)
+      table_remove_row(&t, row);
+
+   if (table_get_row_length(&t) != num_rows || !table_row_is_removed(&t, 1) || table_row_is_removed(&t, 2) ||
+       table_cell_has_value(&t, 1, id_col) || table_get_int(&t, 2, id_col) != 4 || t.rows_removed != num_rows / 2)
+   {
+      printf("Failed to tombstone rows\n");
+      rc = -1;
+   }
+
+   removed = 0;
+   if (table_remove_row(&t, 1) != -1 || table_remove_row(&t, -1) != -1 || table_remove_row(&t, num_rows) != -1 ||
+       removed || t.rows_removed != num_rows / 2)
+   {
+      printf("Removed a row that was already removed or out of range\n");
+      rc = -1;
+   }
+
+   /* Values set on a tombstone would outlive it */
+   snprintf(name, sizeof(name), "%s", table_get_string(&t, 2, name_col));
+   table_set_block(&t, 2, name_col, 2, 1, names, &type);
+   if (table_set_string(&t, 1, name_col, "leaked") != -1 || table_get_string(&t, 1, name_col) ||
+       table_get_string(&t, 3, name_col) || strcmp(table_get_string(&t, 2, name_col), name))
+   {
+      printf("A tombstoned row took a value\n");
+      rc = -1;
+   }
+
+   table_remove_row(&t, 0);
+   if (t.rows_removed || verify(&t, id_col, name_col, 4, 4, num_rows / 2 - 1))
+   {
+      printf("Failed to compact tombstoned rows\n");
+      rc = -1;
+   }
+
+   table_remove_row(&t, 0);
+   if (table_compact_rows(&t) != 1 || verify(&t, id_col, name_col, 8, 4, num_rows / 2 - 2))
+   {
+      printf("Failed to explicitly compact tombstoned rows\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
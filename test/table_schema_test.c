@@ -0,0 +1,98 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+static int added;
+
+static void column_added(table *t, int row, int column, table_event_type event_type, void *data)
+{
+   added++;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   const char *names[16] = { "a", "b", "c" };
+   table_data_type types[16] = { TABLE_INT, TABLE_STRING, TABLE_DOUBLE };
+   char extra_names[13][8];
+   int id_col, first, col, row, num_rows = 100;
+   int rc = 0;
+
+   table_init(&t);
+   table_register_callback(&t, column_added, NULL, TABLE_COLUMN_ADDED);
+
+   id_col = table_add_column(&t, "id", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      table_set_int(&t, row, id_col, row);
+   }
+
+   for (col = 3; col < 16; col++)
+   {
+      snprintf(extra_names[col - 3], sizeof(extra_names[col - 3]), "x%d", col);
+      names[col] = extra_names[col - 3];
+      types[col] = TABLE_INT;
+   }
+
+   first = table_add_columns(&t, names, types, 16);
+   if (first != 1 || table_get_column_length(&t) != 17 || added != 17 ||
+       table_get_column(&t, "c") != 3 || table_get_column_data_type(&t, 2) != TABLE_STRING)
+   {
+      printf("Failed to add columns\n");
+      rc = -1;
+   }
+
+   /* Existing rows are not widened until a new cell is written */
+   if (t.rows[0].cells_allocated >= t.cells_allocated || table_cell_has_value(&t, 0, 1))
+   {
+      printf("Existing rows were touched by the column add\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < num_rows; row += 2)
+   {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      table_set_int(&t, row, 1, row * 2);
+      table_set_string(&t, row, 2, buf);
+   }
+
+   table_remove_column(&t, 1);
+   col = table_add_column(&t, "d", TABLE_INT);
+   if (t.cells_length != 17 || table_column_null_count(&t, col) != num_rows || table_cell_has_value(&t, 0, col))
+   {
+      printf("Removed cell was not reused without a value\n");
+      rc = -1;
+   }
+
+   for (col = 16; col > 2; col--)
+      table_remove_column(&t, col);
+   col = table_add_column(&t, "d", TABLE_INT);
+
+   table_set_int(&t, 5, col, 42);
+   table_shrink_to_fit(&t);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      if (table_get_int(&t, row, id_col) != row || (row % 2 == 0) != table_cell_has_value(&t, row, 1) ||
+          (row % 2 == 0 && strcmp(table_get_string(&t, row, 1), buf)) ||
+          table_cell_has_value(&t, row, col) != (row == 5) || t.rows[row].cells_allocated != 4)
+      {
+         printf("Row %d was not preserved by compaction\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   if (table_get_int(&t, 5, col) != 42)
+   {
+      printf("Failed to retrieve value after compaction\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,91 @@
+#include <table.h>
+#include <stdio.h>
+
+static int compare_cells(table *t, int row1, int row2, int col)
+{
+   int has1 = table_cell_has_value(t, row1, col), has2 = table_cell_has_value(t, row2, col);
+   int value1, value2;
+
+   if (!has1 || !has2)
+      return has1 - has2;
+
+   value1 = table_get_int(t, row1, col);
+   value2 = table_get_int(t, row2, col);
+   return (value1 > value2) - (value1 < value2);
+}
+
+static int check_sorted(table *t, const table_sort_spec *spec, int seq_col)
+{
+   int num_rows = table_get_row_length(t);
+
+   for (int row = 1; row < num_rows; row++)
+   {
+      int cmp = 0;
+      for (int key = 0; !cmp && key < spec->length; key++)
+      {
+         cmp = compare_cells(t, row - 1, row, spec->cols[key]);
+         if (spec->orders[key] == TABLE_DESCENDING)
+            cmp = -cmp;
+      }
+
+      if (cmp > 0 || (!cmp && table_get_int(t, row - 1, seq_col) > table_get_int(t, row, seq_col)))
+      {
+         printf("Row %d is not stably sorted\n", row);
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_sort_spec spec;
+   int cols[3] = { 0, 1, 2 };
+   table_order orders[3] = { TABLE_ASCENDING, TABLE_DESCENDING, TABLE_ASCENDING };
+   int seq_col, row, col, num_rows = 5000;
+   int rc = 0;
+
+   srand(7);
+   table_init(&t);
+
+   table_add_column(&t, "a", TABLE_INT);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   table_add_column(&t, "b", TABLE_INT);
+   table_set_storage(&t, TABLE_ROW_STORAGE);
+   table_add_column(&t, "c", TABLE_INT);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+
+   table_append_rows(&t, num_rows);
+   table_sort_spec_init(&spec, cols, orders, 3);
+
+   for (int pass = 0; pass < 3; pass++)
+   {
+      for (row = 0; row < num_rows; row++)
+      {
+         for (col = 0; col < 3; col++)
+         {
+            if (rand() % 8)
+               table_set_int(&t, row, col, rand() % (4 + col * 3));
+            else
+               table_cell_nullify(&t, row, col);
+         }
+         table_set_int(&t, row, seq_col, row);
+      }
+
+      table_sort(&t, &spec);
+      if (check_sorted(&t, &spec, seq_col))
+      {
+         rc = -1;
+         break;
+      }
+
+      spec.orders[pass % 3] = spec.orders[pass % 3] == TABLE_ASCENDING ? TABLE_DESCENDING : TABLE_ASCENDING;
+   }
+
+   table_sort_spec_destroy(&spec);
+   table_destroy(&t);
+
+   return rc;
+}
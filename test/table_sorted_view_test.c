@@ -0,0 +1,107 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_sorted_view by_price, by_name;
+   table_sort_spec spec;
+   int price_col, name_col, row, num_rows = 500;
+   int price_cols[1], name_cols[2];
+   table_order price_orders[1] = { TABLE_DESCENDING }, name_orders[2] = { TABLE_ASCENDING, TABLE_DESCENDING };
+   int *perm = malloc((num_rows + 1) * sizeof(int));
+   int index, rc = 0;
+
+   srand(5);
+   table_init(&t);
+
+   price_col = table_add_column(&t, "price", TABLE_INT);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "item-%03d", rand() % 100);
+      table_add_row(&t);
+      table_set_int(&t, row, price_col, row * 7 % num_rows);
+      table_set_string(&t, row, name_col, buf);
+   }
+
+   price_cols[0] = price_col;
+   table_sort_spec_init(&spec, price_cols, price_orders, 1);
+   if (table_argsort(&t, &spec, perm) != num_rows)
+   {
+      printf("Unexpected argsort length\n");
+      rc = -1;
+   }
+
+   for (index = 0; index < num_rows; index++)
+   {
+      if (table_get_int(&t, perm[index], price_col) != num_rows - 1 - index || table_get_int(&t, index, price_col) != index * 7 % num_rows)
+      {
+         printf("Argsort index %d is wrong or moved the rows\n", index);
+         rc = -1;
+         break;
+      }
+   }
+   table_sort_spec_destroy(&spec);
+
+   /* Two views with their own order of the same rows */
+   name_cols[0] = name_col;
+   name_cols[1] = price_col;
+   table_sorted_view_init(&by_price, &t, price_cols, price_orders, 1);
+   table_sorted_view_init(&by_name, &t, name_cols, name_orders, 2);
+   for (index = 1; index < num_rows; index++)
+   {
+      int cmp = strcmp(table_sorted_view_get(&by_name, index - 1, name_col), table_sorted_view_get(&by_name, index, name_col));
+      if (table_get_int(&t, table_sorted_view_get_row(&by_price, index), price_col) != num_rows - 1 - index ||
+          cmp > 0 || (!cmp && *(int*)table_sorted_view_get(&by_name, index - 1, price_col) < *(int*)table_sorted_view_get(&by_name, index, price_col)))
+      {
+         printf("View index %d is out of order\n", index);
+         rc = -1;
+         break;
+      }
+   }
+
+   {
+      int price = 42;
+      index = table_sorted_view_find(&by_price, price_col, &price, TABLE_FIRST);
+      if (index != num_rows - 1 - 42 || table_get_int(&t, table_sorted_view_get_row(&by_price, index), price_col) != 42)
+      {
+         printf("Failed to find a value through a descending view, got %d\n", index);
+         rc = -1;
+      }
+   }
+
+   index = table_sorted_view_find(&by_name, name_col, "item-050", TABLE_FIRST);
+   if (index < 0 || strcmp(table_sorted_view_get(&by_name, index, name_col), "item-050") ||
+       (index && !strcmp(table_sorted_view_get(&by_name, index - 1, name_col), "item-050")))
+   {
+      printf("Failed to find the first string through a view\n");
+      rc = -1;
+   }
+
+   row = table_add_row(&t);
+   table_set_int(&t, row, price_col, 10000);
+   table_set_string(&t, row, name_col, "item-000");
+   if (table_sorted_view_is_valid(&by_price))
+   {
+      printf("A view missing a row is reported valid\n");
+      rc = -1;
+   }
+
+   table_sorted_view_refresh(&by_price);
+   if (!table_sorted_view_is_valid(&by_price) || table_sorted_view_get_row(&by_price, 0) != row)
+   {
+      printf("Refreshing the view did not take in the new row\n");
+      rc = -1;
+   }
+
+   table_sorted_view_destroy(&by_name);
+   table_sorted_view_destroy(&by_price);
+   table_destroy(&t);
+   free(perm);
+
+   return rc;
+}
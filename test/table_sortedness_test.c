@@ -0,0 +1,133 @@
+#include <table.h>
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int key_col, other_col, row, num_rows = 50;
+   int cols[1];
+   table_order orders[1] = { TABLE_ASCENDING };
+   int value, first, last;
+   int rc = 0;
+
+   table_init(&t);
+
+   key_col = table_add_column(&t, "key", TABLE_INT);
+   other_col = table_add_column(&t, "other", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      table_set_int(&t, row, key_col, (row * 17) % num_rows);
+   }
+
+   if (table_is_sorted(&t) || table_resort(&t) != -1)
+   {
+      printf("A table that was never sorted is reported sorted\n");
+      rc = -1;
+   }
+
+   cols[0] = key_col;
+   table_column_sort(&t, cols, orders, 1);
+   if (!table_is_sorted(&t) || table_get_sort_spec(&t)->length != 1 || table_get_sort_spec(&t)->cols[0] != key_col)
+   {
+      printf("The sort was not remembered\n");
+      rc = -1;
+   }
+
+   /* Appending in order, changing other columns and removing rows keep the order */
+   row = table_add_row(&t);
+   table_set_int(&t, row, key_col, num_rows + 1);
+   table_set_int(&t, 3, other_col, 99);
+   table_set_int(&t, 10, key_col, 10);
+   table_remove_row(&t, 0);
+   if (!table_is_sorted(&t))
+   {
+      printf("Changes keeping the order were reported out of order\n");
+      rc = -1;
+   }
+
+   table_set_int(&t, 5, key_col, 1000);
+   if (table_is_sorted(&t))
+   {
+      printf("A change out of order was not noticed\n");
+      rc = -1;
+   }
+
+   if (table_sorted_find_int(&t, key_col, 1000, TABLE_FIRST) >= 0)
+   {
+      printf("Binary search re-sorted without being asked to\n");
+      rc = -1;
+   }
+
+   /* Only lookups through a table that is not const re-sort it */
+   table_set_sort_on_find(&t, true);
+   value = 1000;
+   if (table_sorted_find_int(&t, key_col, 1000, TABLE_FIRST) >= 0 || table_is_sorted(&t))
+   {
+      printf("Binary search of a const table re-sorted it\n");
+      rc = -1;
+   }
+
+   if (table_sorted_lookup(&t, key_col, &value, TABLE_FIRST) != table_get_row_length(&t) - 1 || !table_is_sorted(&t))
+   {
+      printf("Lookup did not re-sort the table\n");
+      rc = -1;
+   }
+
+   /* An appended row left without a key is out of order ascending */
+   table_add_row(&t);
+   if (table_is_sorted(&t) ||
+       table_sorted_lookup_equal_range(&t, key_col, &value, &first, &last) != 1 || first != table_get_row_length(&t) - 1)
+   {
+      printf("A row without a key was not re-sorted\n");
+      rc = -1;
+   }
+
+   /* A descending sort is re-sorted and searched in descending order */
+   orders[0] = TABLE_DESCENDING;
+   table_column_sort(&t, cols, orders, 1);
+   table_set_int(&t, 0, key_col, 25);
+   value = 25;
+   row = table_sorted_lookup(&t, key_col, &value, TABLE_FIRST);
+   if (!table_is_sorted(&t) || row <= 0 || table_get_int(&t, row, key_col) != 25 ||
+       table_get_int(&t, row - 1, key_col) <= 25 || table_get_int(&t, row + 2, key_col) >= 25 ||
+       table_sorted_find_int(&t, key_col, 25, TABLE_LAST) != row + 1 ||
+       table_get_int(&t, table_sorted_find_int(&t, key_col, 49, TABLE_FIRST), key_col) != 49)
+   {
+      printf("A descending sort was not searched in descending order\n");
+      rc = -1;
+   }
+
+   /* A tombstone keeps its place without a key until the table is compacted */
+   table_column_sort(&t, cols, orders, 1);
+   table_set_tombstone_threshold(&t, 0.5);
+   row = table_sorted_find_int(&t, key_col, 30, TABLE_FIRST);
+   table_remove_row(&t, row - 1);
+   value = 30;
+   if (table_is_sorted(&t) || table_sorted_lookup(&t, key_col, &value, TABLE_FIRST) < 0 ||
+       table_sorted_lookup_equal_range(&t, key_col, &value, &first, &last) != 1 ||
+       table_get_int(&t, first, key_col) != 30 || table_row_is_removed(&t, first))
+   {
+      printf("A tombstoned row was left in the sorted order\n");
+      rc = -1;
+   }
+   table_compact_rows(&t);
+
+   table_remove_column(&t, other_col);
+   if (!table_is_sorted(&t) || table_get_sort_spec(&t)->cols[0] != key_col)
+   {
+      printf("Removing another column lost the sort\n");
+      rc = -1;
+   }
+
+   table_remove_column(&t, key_col);
+   if (table_is_sorted(&t) || table_get_sort_spec(&t)->length)
+   {
+      printf("Removing the sort column kept the sort\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,64 @@
+#include <table.h>
+#include <stdio.h>
+
+static int check_sorted(table *t, int key_col, int seq_col, table_order order)
+{
+   int num_rows = table_get_row_length(t);
+
+   for (int row = 1; row < num_rows; row++)
+   {
+      int prev_has = table_cell_has_value(t, row - 1, key_col), has = table_cell_has_value(t, row, key_col);
+      int prev = prev_has ? table_get_int(t, row - 1, key_col) : 0, value = has ? table_get_int(t, row, key_col) : 0;
+      int cmp = prev_has != has ? prev_has - has : (prev > value) - (prev < value);
+
+      if (order == TABLE_DESCENDING)
+         cmp = -cmp;
+
+      if (cmp > 0 || (!cmp && table_get_int(t, row - 1, seq_col) > table_get_int(t, row, seq_col)))
+      {
+         printf("Row %d is not stably sorted %s\n", row, order == TABLE_ASCENDING ? "ascending" : "descending");
+         return -1;
+      }
+   }
+
+   return 0;
+}
+
+int main(int argc, char **argv)
+{
+   table t;
+   int key_col, seq_col, row, num_rows = 10000;
+   int cols[1];
+   table_order orders[1];
+   int rc = 0;
+
+   srand(42);
+   table_init(&t);
+
+   key_col = table_add_column(&t, "key", TABLE_INT);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      if (rand() % 10)
+         table_set_int(&t, row, key_col, rand() % 50);
+   }
+
+   cols[0] = key_col;
+   for (int pass = 0; pass < 2; pass++)
+   {
+      orders[0] = pass ? TABLE_DESCENDING : TABLE_ASCENDING;
+
+      /* Number the rows in their current order, ties must keep it */
+      for (row = 0; row < num_rows; row++)
+         table_set_int(&t, row, seq_col, row);
+
+      table_column_sort(&t, cols, orders, 1);
+      if (check_sorted(&t, key_col, seq_col, orders[0]))
+         rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,100 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int id_col, name_col, value_col, row_col;
+   int row, num_rows = 100;
+   int cols[1];
+   table_order orders[1] = { TABLE_DESCENDING };
+   int rc = 0;
+
+   table_init(&t);
+
+   id_col = table_add_column(&t, "id", TABLE_INT32);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   value_col = table_add_column(&t, "value", TABLE_DOUBLE);
+   row_col = table_add_column(&t, "row", TABLE_INT);
+
+   if (table_get_column_storage(&t, id_col) != TABLE_ROW_STORAGE ||
+       table_get_column_storage(&t, value_col) != TABLE_COLUMN_STORAGE)
+   {
+      printf("Unexpected column storage\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      table_add_row(&t);
+      table_set_int32(&t, row, id_col, row);
+      table_set_string(&t, row, name_col, buf);
+      table_set_double(&t, row, value_col, row * 0.5);
+      if (row % 3)
+         table_set_int(&t, row, row_col, row);
+   }
+
+   if (table_get_double(&t, 42, value_col) != 21.0 || strcmp(table_get_string(&t, 42, name_col), "name-42"))
+   {
+      printf("Failed to retrieve column storage values\n");
+      rc = -1;
+   }
+
+   if (table_cell_has_value(&t, 3, row_col) || !table_cell_has_value(&t, 4, row_col))
+   {
+      printf("Unexpected column storage validity\n");
+      rc = -1;
+   }
+
+   if (table_find_double(&t, value_col, 10.0, TABLE_ASCENDING) != 20)
+   {
+      printf("Failed to find column storage value\n");
+      rc = -1;
+   }
+
+   table_remove_row(&t, 10);
+   if (table_get_int32(&t, 10, id_col) != 11 || table_get_double(&t, 10, value_col) != 5.5 ||
+       table_cell_has_value(&t, 11, row_col) || table_get_int(&t, 10, row_col) != 11)
+   {
+      printf("Column storage values were not shifted after row removal\n");
+      rc = -1;
+   }
+
+   cols[0] = value_col;
+   table_column_sort(&t, cols, orders, 1);
+   num_rows = table_get_row_length(&t);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      int id = table_get_int32(&t, row, id_col);
+      snprintf(buf, sizeof(buf), "name-%d", id);
+      if (table_get_double(&t, row, value_col) != id * 0.5 || strcmp(table_get_string(&t, row, name_col), buf) ||
+          table_cell_has_value(&t, row, row_col) != (id % 3 != 0))
+      {
+         printf("Row %d was not sorted consistently across storage layouts\n", row);
+         rc = -1;
+         break;
+      }
+      if (row && table_get_double(&t, row - 1, value_col) < table_get_double(&t, row, value_col))
+      {
+         printf("Row %d is not sorted correctly\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   table_remove_column(&t, name_col);
+   if (table_get_double(&t, 0, table_get_column(&t, "value")) != (num_rows) * 0.5)
+   {
+      printf("Failed to retrieve value after column removal\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,93 @@
+#include <table.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int key_col, name_col, seq_col, row, num_rows = 2000, k = 100;
+   int cols[2];
+   table_order orders[2] = { TABLE_DESCENDING, TABLE_ASCENDING };
+   int top[100];
+   int found, rc = 0;
+
+   srand(3);
+   table_init(&t);
+
+   key_col = table_add_column(&t, "key", TABLE_DOUBLE);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   seq_col = table_add_column(&t, "seq", TABLE_INT);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "n%d", rand() % 5);
+      table_add_row(&t);
+      if (rand() % 20)
+         table_set_double(&t, row, key_col, rand() % 200);
+      table_set_string(&t, row, name_col, buf);
+      table_set_int(&t, row, seq_col, row);
+   }
+
+   cols[0] = key_col;
+   cols[1] = name_col;
+   found = table_top_k(&t, cols, orders, 2, k, top);
+   if (found != k)
+   {
+      printf("Expected %d rows, found %d\n", k, found);
+      rc = -1;
+   }
+
+   for (row = 0; row < num_rows; row++)
+   {
+      if (table_get_int(&t, row, seq_col) != row)
+      {
+         printf("Finding the top rows moved row %d\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   /* Only the first rows are sorted, the rest keep their order */
+   if (table_partial_sort(&t, cols, orders, 2, k) != k)
+   {
+      printf("Failed to partially sort\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < k; row++)
+   {
+      if (table_get_int(&t, row, seq_col) != top[row])
+      {
+         printf("Row %d of the partial sort is not top row %d\n", row, top[row]);
+         rc = -1;
+         break;
+      }
+   }
+
+   for (row = k + 1; row < num_rows; row++)
+   {
+      if (table_get_int(&t, row - 1, seq_col) > table_get_int(&t, row, seq_col))
+      {
+         printf("Row %d after the partial sort was moved out of order\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   /* The top rows match the start of a full stable sort */
+   table_column_sort(&t, &seq_col, orders + 1, 1);
+   table_column_sort(&t, cols, orders, 2);
+   for (row = 0; row < k; row++)
+   {
+      if (table_get_int(&t, row, seq_col) != top[row])
+      {
+         printf("Top row %d differs from the full sort\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
@@ -0,0 +1,88 @@
+#include <table.h>
+#include <stdio.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   int row_col, col_col, row, num_rows = 300;
+   int cols[1];
+   table_order orders[1] = { TABLE_ASCENDING };
+   int rc = 0;
+
+   table_init(&t);
+
+   row_col = table_add_column(&t, "row", TABLE_INT);
+   table_set_storage(&t, TABLE_COLUMN_STORAGE);
+   col_col = table_add_column(&t, "column", TABLE_INT);
+
+   for (row = 0; row < num_rows; row++)
+   {
+      table_add_row(&t);
+      if (row >= 64 && row < 256)
+         continue;
+      table_set_int(&t, row, row_col, row);
+      table_set_int(&t, row, col_col, row);
+   }
+
+   if (table_column_null_count(&t, row_col) != 192 || table_column_null_count(&t, col_col) != 192)
+   {
+      printf("Expected 192 rows without a value, got %d and %d\n", table_column_null_count(&t, row_col), table_column_null_count(&t, col_col));
+      rc = -1;
+   }
+
+   if (table_get_column_validity(&t, col_col)[2] || !(table_get_column_validity(&t, col_col)[0] & 1))
+   {
+      printf("Unexpected validity bitmap\n");
+      rc = -1;
+   }
+
+   if (table_find_int(&t, col_col, 260, TABLE_ASCENDING) != 260 || table_find_int(&t, row_col, 10, TABLE_DESCENDING) != 10)
+   {
+      printf("Failed to find a value across rows without a value\n");
+      rc = -1;
+   }
+
+   table_remove_row(&t, 0);
+   table_cell_nullify(&t, 0, col_col);
+   if (table_column_null_count(&t, row_col) != 192 || table_column_null_count(&t, col_col) != 193)
+   {
+      printf("Null count was not maintained\n");
+      rc = -1;
+   }
+
+   cols[0] = col_col;
+   table_column_sort(&t, cols, orders, 1);
+   num_rows = table_get_row_length(&t);
+   for (row = 0; row < num_rows; row++)
+   {
+      bool has_value = table_cell_has_value(&t, row, col_col);
+      if (has_value != (row >= 193))
+      {
+         printf("Row %d should %shave a value after sorting\n", row, has_value ? "not " : "");
+         rc = -1;
+         break;
+      }
+      if (has_value && row > 193 && table_get_int(&t, row - 1, col_col) > table_get_int(&t, row, col_col))
+      {
+         printf("Row %d is not sorted correctly\n", row);
+         rc = -1;
+         break;
+      }
+   }
+
+   for (row = 0; row < num_rows; row++)
+   {
+      table_set_int(&t, row, row_col, row);
+      table_set_int(&t, row, col_col, row);
+   }
+
+   if (!table_column_is_dense(&t, row_col) || !table_column_is_dense(&t, col_col))
+   {
+      printf("Columns should be dense\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}
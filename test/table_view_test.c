@@ -0,0 +1,98 @@
+#include <table.h>
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv)
+{
+   table t;
+   table_column_view view;
+   int value_col, name_col, row, num_rows = 1000;
+   double sum = 0.0;
+   int rc = 0;
+
+   table_init(&t);
+
+   value_col = table_add_column(&t, "value", TABLE_DOUBLE);
+   name_col = table_add_column(&t, "name", TABLE_STRING);
+   for (row = 0; row < num_rows; row++)
+   {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "name-%d", row);
+      table_add_row(&t);
+      if (row % 4)
+         table_set_double(&t, row, value_col, row);
+      table_set_string(&t, row, name_col, buf);
+   }
+
+   view = table_get_column_view(&t, value_col);
+   if (table_get_column_storage(&t, value_col) != TABLE_COLUMN_STORAGE || view.length != num_rows ||
+       view.type != TABLE_DOUBLE || view.stride != sizeof(double) || view.null_count != num_rows / 4)
+   {
+      printf("Unexpected column view\n");
+      rc = -1;
+   }
+
+   for (row = 0; row < view.length; row++)
+      if (view.validity[row / 64] >> (row % 64) & 1)
+         sum += *(const double*)((const char*)view.base + view.stride * row);
+
+   if (sum != 375000.0)
+   {
+      printf("Failed to sum the column view\n");
+      rc = -1;
+   }
+
+   /* Storing values keeps the view valid */
+   table_set_double(&t, 5, value_col, -1.0);
+   if (!table_column_view_is_valid(&t, &view) || ((const double*)view.base)[5] != -1.0)
+   {
+      printf("Column view was invalidated by storing a value\n");
+      rc = -1;
+   }
+
+   table_remove_row(&t, 0);
+   if (table_column_view_is_valid(&t, &view))
+   {
+      printf("Column view was not invalidated by removing a row\n");
+      rc = -1;
+   }
+
+   view = table_get_column_view(&t, name_col);
+   if (strcmp(((char * const*)view.base)[10], "name-11"))
+   {
+      printf("Unexpected string column view\n");
+      rc = -1;
+   }
+
+   table_set_column_storage(&t, value_col, TABLE_ROW_STORAGE);
+   table_set_column_storage(&t, name_col, TABLE_ROW_STORAGE);
+   if (table_column_view_is_valid(&t, &view) || table_get_column_storage(&t, name_col) != TABLE_ROW_STORAGE ||
+       table_get_double(&t, 4, value_col) != -1.0 || table_cell_has_value(&t, 3, value_col) ||
+       strcmp(table_get_string(&t, 998, name_col), "name-999") || table_column_null_count(&t, value_col) != num_rows / 4 - 1)
+   {
+      printf("Failed to move columns back to row storage\n");
+      rc = -1;
+   }
+
+   /* Adding rows within the allocated rows invalidates a view as well */
+   table_reserve_rows(&t, num_rows + 10);
+   view = table_get_column_view(&t, value_col);
+   table_add_row(&t);
+   if (table_column_view_is_valid(&t, &view))
+   {
+      printf("Column view was not invalidated by adding a row\n");
+      rc = -1;
+   }
+
+   view = table_get_column_view(&t, value_col);
+   table_append_rows(&t, 5);
+   if (table_column_view_is_valid(&t, &view))
+   {
+      printf("Column view was not invalidated by appending rows\n");
+      rc = -1;
+   }
+
+   table_destroy(&t);
+
+   return rc;
+}